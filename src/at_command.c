@@ -1,10 +1,15 @@
 #include <zephyr/kernel.h>
+#include <zephyr/init.h>
 #include <zephyr/drivers/uart.h>
 #include <zephyr/logging/log.h>
 #include <string.h>
+#include <errno.h>
 #include <stdio.h>
 #include <zephyr/sys/ring_buffer.h>
+#include <zephyr/sys/crc.h>
 #include "hmi_uart.h"
+#include "at_command.h"
+#include "nus_sink.h"
 #include "cat.h"
 #include "value_reporter.h"
 
@@ -13,10 +18,81 @@ LOG_MODULE_REGISTER(at_parser_app, LOG_LEVEL_INF);
 // --- Zephyr 相關定義 ---
 #define STACK_SIZE 8192
 #define THREAD_PRIORITY 7
+// 每次批次處理最多執行的解析器狀態步數
+#define AT_PARSER_SERVICE_STEPS 1024
 #define AT_CMD_UART DT_ALIAS(atcmduart)
+// 每個工作階段的工作緩衝區大小
+#define AT_SESSION_WORKING_BUF_SIZE 256
+// 每個工作階段的參數暫存區大小：參數先解碼到這裡，整行被接受後才寫入共用的命令變數
+// (cat_init 會檢查是否放得下每個命令的所有變數)
+#define AT_SESSION_VAR_BUF_SIZE 128
+// 單筆 NUS 寫入的最大長度：ACL 接收緩衝區扣除 L2CAP (4 bytes) 與 ATT (3 bytes) 標頭
+#define AT_SESSION_NUS_WRITE_MAX (CONFIG_BT_BUF_ACL_RX_SIZE - 4 - 3)
+// 每條 BLE 連線的輸入環形緩衝區大小：解析器還在處理上一筆最大寫入時，仍放得下下一筆完整的寫入，另留 64 bytes 餘裕
+#define AT_SESSION_NUS_RX_BUF_SIZE MAX(256, 2 * AT_SESSION_NUS_WRITE_MAX + 64)
+// UART 一個工作階段，加上每條 BLE 連線各一個
+#define AT_SESSION_NUS_NUM CONFIG_BT_MAX_CONN
+#define AT_SESSION_NUM (1 + AT_SESSION_NUS_NUM)
+// 每個工作階段可暫存的非請求結果碼 (URC) 數量
+#define AT_URC_QUEUE_DEPTH CONFIG_AT_URC_QUEUE_DEPTH
+// 一筆 URC 最大長度：文字回報或一個二進位回報框架
+#define AT_URC_MAX_LEN MAX(MAX_REPORT_LINE_LEN, REPORT_FRAME_MAX_LEN)
 RING_BUF_DECLARE(uart_at_ringbuf, 1024);
-struct hmi_uart_data at_cmd_uart_instance_data = {.dev = DEVICE_DT_GET(AT_CMD_UART), .rx_rbuf = &uart_at_ringbuf};
+RING_BUF_DECLARE(uart_at_tx_ringbuf, 1024);
+K_SEM_DEFINE(at_parser_sem, 0, 1);
+struct hmi_uart_data at_cmd_uart_instance_data = {
+    .dev = DEVICE_DT_GET(AT_CMD_UART),
+    .rx_rbuf = &uart_at_ringbuf,
+    .rx_sem = &at_parser_sem,
+    .hw_flow_ctrl = DT_PROP_OR(AT_CMD_UART, hw_flow_control, false),
+    .tx_rbuf = &uart_at_tx_ringbuf,
+    .tx_sem = &at_parser_sem,
+};
 K_MUTEX_DEFINE(cat_mutex);
+// 保護工作階段的建立、查找與釋放，只在存取 active/in_service 或放入 URC 時短暫持有，
+// 解析與發送回應 (bt_nus_send 可能阻塞) 期間不持有
+K_MUTEX_DEFINE(at_session_mutex);
+
+// 一筆 URC
+struct at_urc {
+    uint8_t len;                        // 資料長度 (文字不含 '\0')
+    bool binary;                        // 二進位框架原樣送出，不加換行
+    uint8_t data[AT_URC_MAX_LEN];
+};
+
+// AT 工作階段：每個傳輸通道 (UART 或 BLE 連線) 擁有獨立的輸入、解析器狀態與工作緩衝區，
+// 命令表則由所有工作階段共用
+struct at_session {
+    bool active;                        // 工作階段是否使用中
+    bool in_service;                    // 解析器執行緒正在處理此工作階段，結束前不可重新分配
+    struct ring_buf *rx_rbuf;           // 此工作階段專屬的輸入環形緩衝區
+    struct hmi_uart_data *uart;         // UART 輸出通道 (BLE 工作階段為 NULL)
+    struct nus_sink *sink;              // BLE NUS 輸出端 (UART 工作階段為 NULL)
+    struct cat_descriptor desc;         // 指向共用命令表與專屬工作緩衝區
+    struct cat_object cat;              // 獨立的解析器狀態
+    uint8_t working_buf[AT_SESSION_WORKING_BUF_SIZE];
+    uint8_t var_buf[AT_SESSION_VAR_BUF_SIZE] __aligned(4); // 參數解碼暫存區 (解析器以 32 位元存取)
+    struct k_msgq urc_q;                // 等待送出的 URC，由回報執行緒放入、解析器執行緒取出
+    char urc_q_buf[AT_URC_QUEUE_DEPTH * sizeof(struct at_urc)];
+    atomic_t urc_dropped;               // 佇列已滿而丟棄的 URC 數量，下次送出時通知主機
+    bool urc_active;                    // URC 命令已交給解析器的非請求事件處理
+    int64_t xdata_deadline;             // +XDATA 資料階段的逾時時間 (系統運行時間 ms)，0 表示沒有進行中的傳輸
+    int64_t xdata_prompt_deadline;      // 命令列以 <cr> 結束時等待 <lf> 的期限，到期後直接送出提示，0 表示沒有在等待
+    uint32_t xdata_len;                 // 最近一次 +XDATA 已接收的位元組數
+    uint16_t xdata_crc;                 // 最近一次 +XDATA 資料的 CRC-16/CCITT
+    uint8_t syshist_sensor_id;          // +SYSHIST 選擇的感測器
+    uint8_t syshist_reg;                // +SYSHIST 選擇的暫存器
+    bool syshist_from_start;            // 下一批從最舊的樣本開始 (忽略 syshist_since)
+    uint32_t syshist_since;             // 下一批的起始時間 (ms)，每批讀取後往後推進
+};
+
+static struct at_session g_sessions[AT_SESSION_NUM];
+// BLE 工作階段的輸入緩衝區與輸出端，依序對應 g_sessions[1..]
+static struct ring_buf g_nus_rx_rbuf[AT_SESSION_NUS_NUM];
+static uint8_t g_nus_rx_data[AT_SESSION_NUS_NUM][AT_SESSION_NUS_RX_BUF_SIZE];
+static struct nus_sink g_nus_sinks[AT_SESSION_NUS_NUM];
+// 解析器目前正在處理的工作階段，I/O 介面函式沒有上下文參數，透過它找到對應的通道
+static struct at_session *g_current_session;
 
 // --- 全局變數定義 ---
 static char g_manufacture_id[32] = "MyCompany";
@@ -29,11 +105,25 @@ static uint32_t g_sysreg_reg = 0;
 static uint32_t g_sysreg_sensor_id = 0;
 static uint32_t g_sysreg_value = 0;
 static uint32_t g_sysreg_interval = 0;
+// interval 的單位 (0: 秒, 1: 毫秒)，省略時為秒
+static uint8_t g_sysreg_unit = VALUE_REPORTER_UNIT_S;
+// 變化觸發回報的門檻與最長靜默時間 (與 interval 相同單位)，省略時關閉
+static uint16_t g_sysreg_deadband = 0;
+static uint32_t g_sysreg_max_silence = 0;
+// 回報模式 (0: 週期取樣, 1: 週期統計 +SYSAGG)，省略時為取樣
+static uint8_t g_sysreg_mode = 0;
+// 歷史查詢條件，寫入後複製到工作階段，讀取進度由每個工作階段各自保存
+static uint8_t g_syshist_sensor_id = 0;
+static uint8_t g_syshist_reg = 0;
+static uint32_t g_syshist_since = 0;
+// 回報格式 (0: 文字, 1: 二進位框架)
+static uint8_t g_sysfmt_format = VALUE_REPORTER_FORMAT_TEXT;
+// +XDATA 宣告的原始資料長度
+static uint32_t g_xdata_len = 0;
 static char g_mqtt_client_id[64] = "cat_parser_client";
 static uint16_t g_mqtt_keep_alive = 60;
 static uint8_t g_mqtt_clean_session = 0;
 
-static char g_working_buffer[256];
 static bool g_quit_flag = false;
 
 // --- 命令處理函式宣告 ---
@@ -50,17 +140,60 @@ static cat_return_state cmd_cgmh_run(const struct cat_command *cmd);
 static cat_return_state cmd_cgmh_test(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size);
 static cat_return_state cmd_sysreg_write(const struct cat_command *cmd, const uint8_t *data, const size_t data_size, const size_t args_num);
 static cat_return_state cmd_sysreg_test(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size);
+static cat_return_state cmd_syshist_read(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size);
+static cat_return_state cmd_syshist_write(const struct cat_command *cmd, const uint8_t *data, const size_t data_size, const size_t args_num);
+static cat_return_state cmd_sysfmt_read(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size);
+static cat_return_state cmd_sysfmt_write(const struct cat_command *cmd, const uint8_t *data, const size_t data_size, const size_t args_num);
+static cat_return_state cmd_xdata_read(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size);
+static cat_return_state cmd_xdata_write(const struct cat_command *cmd, const uint8_t *data, const size_t data_size, const size_t args_num);
+static cat_return_state cmd_xdata_data(const struct cat_command *cmd, const uint8_t *data, const size_t data_size, const size_t remaining);
 static cat_return_state cmd_xmqttcfg_read(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size);
 static cat_return_state cmd_xmqttcfg_write(const struct cat_command *cmd, const uint8_t *data, const size_t data_size, const size_t args_num);
 static cat_return_state cmd_xmqttcfg_test(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size);
 
+static cat_return_state cmd_urc_read(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size);
+
 // --- 命令變數描述符定義 ---
+// +SYSREG 各參數在 g_sysreg_vars 中的位置，args_num 不超過某個位置代表該參數與之後的參數都被省略
+enum sysreg_arg {
+    SYSREG_ARG_RW = 0,
+    SYSREG_ARG_SENSOR_ID,
+    SYSREG_ARG_REG,
+    SYSREG_ARG_VALUE,
+    SYSREG_ARG_INTERVAL,
+    SYSREG_ARG_UNIT,
+    SYSREG_ARG_DEADBAND,
+    SYSREG_ARG_MAX_SILENCE,
+    SYSREG_ARG_MODE,
+    SYSREG_ARG_NUM
+};
+
 static struct cat_variable g_sysreg_vars[] = {
-    { .name = "r/w", .type = CAT_VAR_UINT_DEC, .data = &g_sysreg_rw, .data_size = sizeof(g_sysreg_rw), .access = CAT_VAR_ACCESS_READ_WRITE },
-    { .name = "sensor_id", .type = CAT_VAR_UINT_DEC, .data = &g_sysreg_sensor_id, .data_size = sizeof(g_sysreg_sensor_id), .access = CAT_VAR_ACCESS_READ_WRITE },
-    { .name = "reg", .type = CAT_VAR_BUF_HEX, .data = &g_sysreg_reg, .data_size = sizeof(g_sysreg_reg), .access = CAT_VAR_ACCESS_READ_WRITE },
-    { .name = "value", .type = CAT_VAR_UINT_DEC, .data = &g_sysreg_value, .data_size = sizeof(g_sysreg_value), .access = CAT_VAR_ACCESS_READ_WRITE },
-    { .name = "interval", .type = CAT_VAR_UINT_DEC, .data = &g_sysreg_interval, .data_size = sizeof(g_sysreg_interval), .access = CAT_VAR_ACCESS_READ_WRITE },
+    [SYSREG_ARG_RW] = { .name = "r/w", .type = CAT_VAR_UINT_DEC, .data = &g_sysreg_rw, .data_size = sizeof(g_sysreg_rw), .access = CAT_VAR_ACCESS_READ_WRITE },
+    [SYSREG_ARG_SENSOR_ID] = { .name = "sensor_id", .type = CAT_VAR_UINT_DEC, .data = &g_sysreg_sensor_id, .data_size = sizeof(g_sysreg_sensor_id), .access = CAT_VAR_ACCESS_READ_WRITE },
+    [SYSREG_ARG_REG] = { .name = "reg", .type = CAT_VAR_BUF_HEX, .data = &g_sysreg_reg, .data_size = sizeof(g_sysreg_reg), .access = CAT_VAR_ACCESS_READ_WRITE },
+    [SYSREG_ARG_VALUE] = { .name = "value", .type = CAT_VAR_UINT_DEC, .data = &g_sysreg_value, .data_size = sizeof(g_sysreg_value), .access = CAT_VAR_ACCESS_READ_WRITE },
+    [SYSREG_ARG_INTERVAL] = { .name = "interval", .type = CAT_VAR_UINT_DEC, .data = &g_sysreg_interval, .data_size = sizeof(g_sysreg_interval), .access = CAT_VAR_ACCESS_READ_WRITE },
+    [SYSREG_ARG_UNIT] = { .name = "unit", .type = CAT_VAR_UINT_DEC, .data = &g_sysreg_unit, .data_size = sizeof(g_sysreg_unit), .access = CAT_VAR_ACCESS_READ_WRITE },
+    [SYSREG_ARG_DEADBAND] = { .name = "deadband", .type = CAT_VAR_UINT_DEC, .data = &g_sysreg_deadband, .data_size = sizeof(g_sysreg_deadband), .access = CAT_VAR_ACCESS_READ_WRITE },
+    [SYSREG_ARG_MAX_SILENCE] = { .name = "max_silence", .type = CAT_VAR_UINT_DEC, .data = &g_sysreg_max_silence, .data_size = sizeof(g_sysreg_max_silence), .access = CAT_VAR_ACCESS_READ_WRITE },
+    [SYSREG_ARG_MODE] = { .name = "mode", .type = CAT_VAR_UINT_DEC, .data = &g_sysreg_mode, .data_size = sizeof(g_sysreg_mode), .access = CAT_VAR_ACCESS_READ_WRITE },
+};
+BUILD_ASSERT(ARRAY_SIZE(g_sysreg_vars) == SYSREG_ARG_NUM, "every +SYSREG argument needs a variable");
+
+// 只允許寫入，讀取時直接由 read 函式輸出歷史資料
+static struct cat_variable g_syshist_vars[] = {
+    { .name = "sensor_id", .type = CAT_VAR_UINT_DEC, .data = &g_syshist_sensor_id, .data_size = sizeof(g_syshist_sensor_id), .access = CAT_VAR_ACCESS_WRITE_ONLY },
+    { .name = "reg", .type = CAT_VAR_BUF_HEX, .data = &g_syshist_reg, .data_size = sizeof(g_syshist_reg), .access = CAT_VAR_ACCESS_WRITE_ONLY },
+    { .name = "since", .type = CAT_VAR_UINT_DEC, .data = &g_syshist_since, .data_size = sizeof(g_syshist_since), .access = CAT_VAR_ACCESS_WRITE_ONLY },
+};
+
+static struct cat_variable g_sysfmt_vars[] = {
+    { .name = "format", .type = CAT_VAR_UINT_DEC, .data = &g_sysfmt_format, .data_size = sizeof(g_sysfmt_format), .access = CAT_VAR_ACCESS_READ_WRITE },
+};
+
+static struct cat_variable g_xdata_vars[] = {
+    { .name = "len", .type = CAT_VAR_UINT_DEC, .data = &g_xdata_len, .data_size = sizeof(g_xdata_len), .access = CAT_VAR_ACCESS_WRITE_ONLY },
 };
 
 static struct cat_variable g_mqtt_vars[] = {
@@ -84,6 +217,33 @@ static struct cat_command g_cmds[] = {
         .var = g_sysreg_vars,
         .var_num = sizeof(g_sysreg_vars) / sizeof(g_sysreg_vars[0]),
     },
+    {
+        .name = "+SYSHIST",
+        .description = "Select register history (sensor_id,reg[,since ms]), read to dump it.",
+        .write = cmd_syshist_write,
+        .read = cmd_syshist_read,
+        .var = g_syshist_vars,
+        .var_num = sizeof(g_syshist_vars) / sizeof(g_syshist_vars[0]),
+    },
+    {
+        .name = "+SYSFMT",
+        .description = "Register report format (0: text, 1: binary frames).",
+        .write = cmd_sysfmt_write,
+        .read = cmd_sysfmt_read,
+        .var = g_sysfmt_vars,
+        .var_num = sizeof(g_sysfmt_vars) / sizeof(g_sysfmt_vars[0]),
+        .need_all_vars = true,
+    },
+    {
+        .name = "+XDATA",
+        .description = "Send <len> raw bytes after the '>' prompt, read back length and CRC of the last transfer.",
+        .write = cmd_xdata_write,
+        .read = cmd_xdata_read,
+        .data = cmd_xdata_data,
+        .var = g_xdata_vars,
+        .var_num = sizeof(g_xdata_vars) / sizeof(g_xdata_vars[0]),
+        .need_all_vars = true,
+    },
     {
         .name = "#XMQTTCFG",
         .description = "MQTT client configuration.",
@@ -97,25 +257,51 @@ static struct cat_command g_cmds[] = {
 };
 
 // --- Zephyr I/O 介面實現 ---
+// 輸出到目前工作階段的通道，回傳實際接受的位元組數
+static size_t session_write(const uint8_t *buf, size_t len) {
+    struct at_session *session = g_current_session;
+
+    if (session->uart != NULL) {
+        // 發送緩衝區滿時只接受部分資料，解析器會在稍後重試剩餘的部分
+        int ret = hmi_uart_send(session->uart, buf, len);
+        return (ret > 0) ? ret : 0;
+    }
+    return nus_sink_write(session->sink, buf, len);
+}
+
 static int write_char(char ch) {
     LOG_DBG("Sent: %c\n",(ch));
-    hmi_uart_send(at_cmd_uart_instance_data.dev, &ch, 1);
-    return 1;
+    return (session_write((const uint8_t *)&ch, 1) == 1) ? 1 : 0;
+}
+
+static size_t write_block(const uint8_t *buf, size_t len) {
+    return session_write(buf, len);
 }
 
 static int read_char(char *ch) {
     int ret = 0;
-    ret = ring_buf_get(&uart_at_ringbuf, ch, 1);
+    ret = ring_buf_get(g_current_session->rx_rbuf, ch, 1);
     if(ret != 0)
     {
         LOG_DBG("Get: %c\n",(uint8_t)(*ch));
-        //LOG_INF("head:%d,tail:%d,base:%d\n",uart_at_ringbuf.get_head,uart_at_ringbuf.get_tail,uart_at_ringbuf.get_base);
-        
         return 1;
     }
     return 0;
 }
 
+static size_t read_block(const char **buf, size_t consumed) {
+    struct at_session *session = g_current_session;
+
+    // 釋放解析器已處理完的區段，再直接取得環形緩衝區中下一段連續資料 (不複製)
+    if (consumed > 0) {
+        ring_buf_get_finish(session->rx_rbuf, consumed);
+        if (session->uart != NULL) {
+            hmi_uart_rx_resume(session->uart);
+        }
+    }
+    return ring_buf_get_claim(session->rx_rbuf, (uint8_t **)buf, ring_buf_capacity_get(session->rx_rbuf));
+}
+
 // --- 互斥鎖介面實現 ---
 static int mutex_lock(void) {
     return k_mutex_lock(&cat_mutex, K_FOREVER);
@@ -127,7 +313,9 @@ static int mutex_unlock(void) {
 
 static struct cat_io_interface g_iface = {
     .read = read_char,
-    .write = write_char
+    .write = write_char,
+    .write_block = write_block,
+    .read_block = read_block
 };
 
 static struct cat_mutex_interface g_mutex = {
@@ -135,6 +323,181 @@ static struct cat_mutex_interface g_mutex = {
     .unlock = mutex_unlock
 };
 
+void at_command_notify(void) {
+    k_sem_give(&at_parser_sem);
+}
+
+// 送出 URC 用的命令，不在命令表中，主機無法直接下達
+static struct cat_command g_urc_cmd = {
+    .name = "+URC",
+    .read = cmd_urc_read,
+};
+
+static struct cat_command_group g_cmd_group_obj = {
+    .cmd = g_cmds,
+    .cmd_num = sizeof(g_cmds) / sizeof(g_cmds[0]),
+};
+
+static struct cat_command_group *g_cmd_desc[] = {
+    &g_cmd_group_obj
+};
+
+// 啟用工作階段：綁定共用命令表與專屬工作緩衝區，並重設解析器狀態
+// 命令表超出解析器索引容量時回傳 -EINVAL，工作階段保持未啟用
+static int at_session_open(struct at_session *session) {
+    session->desc.cmd_group = g_cmd_desc;
+    session->desc.cmd_group_num = sizeof(g_cmd_desc) / sizeof(g_cmd_desc[0]);
+    session->desc.buf = session->working_buf;
+    session->desc.buf_size = sizeof(session->working_buf);
+    session->desc.var_buf = session->var_buf;
+    session->desc.var_buf_size = sizeof(session->var_buf);
+    if (cat_init(&session->cat, &session->desc, &g_iface, &g_mutex) != CAT_STATUS_OK) {
+        LOG_ERR("Command table does not fit the parser tables");
+        return -EINVAL;
+    }
+    k_msgq_purge(&session->urc_q);
+    atomic_set(&session->urc_dropped, 0);
+    session->urc_active = false;
+    session->xdata_deadline = 0;
+    session->xdata_prompt_deadline = 0;
+    session->xdata_len = 0;
+    session->xdata_crc = 0;
+    session->syshist_sensor_id = 0;
+    session->syshist_reg = 0;
+    session->syshist_from_start = true;
+    session->syshist_since = 0;
+    session->active = true;
+    return 0;
+}
+
+// 找出 BLE 連線對應的工作階段，呼叫端必須持有 at_session_mutex
+static struct at_session *at_session_find_nus(struct bt_conn *conn) {
+    for (size_t i = 1; i < AT_SESSION_NUM; i++) {
+        struct at_session *session = &g_sessions[i];
+        if (session->active && nus_sink_get_conn(session->sink) == conn) {
+            return session;
+        }
+    }
+    return NULL;
+}
+
+// 在藍牙啟用前初始化工作階段表，確保連線回調可以安全使用
+static int at_command_session_init(void) {
+    for (size_t i = 0; i < AT_SESSION_NUM; i++) {
+        k_msgq_init(&g_sessions[i].urc_q, g_sessions[i].urc_q_buf, sizeof(struct at_urc), AT_URC_QUEUE_DEPTH);
+    }
+    g_sessions[0].rx_rbuf = &uart_at_ringbuf;
+    g_sessions[0].uart = &at_cmd_uart_instance_data;
+    for (size_t i = 0; i < AT_SESSION_NUS_NUM; i++) {
+        ring_buf_init(&g_nus_rx_rbuf[i], sizeof(g_nus_rx_data[i]), g_nus_rx_data[i]);
+        nus_sink_init(&g_nus_sinks[i]);
+        g_sessions[1 + i].rx_rbuf = &g_nus_rx_rbuf[i];
+        g_sessions[1 + i].sink = &g_nus_sinks[i];
+    }
+    return 0;
+}
+SYS_INIT(at_command_session_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+// 連線回調都在藍牙接收執行緒中依序執行；nus_sink 的操作可能等待正在發送的 bt_nus_send，不在 at_session_mutex 內進行
+void at_command_nus_connected(struct bt_conn *conn) {
+    struct at_session *session = NULL;
+    int err;
+
+    k_mutex_lock(&at_session_mutex, K_FOREVER);
+    for (size_t i = 1; i < AT_SESSION_NUM; i++) {
+        // 剛中斷但解析器還在處理的工作階段，等它處理完才能重新使用
+        if (!g_sessions[i].active && !g_sessions[i].in_service) {
+            session = &g_sessions[i];
+            break;
+        }
+    }
+    k_mutex_unlock(&at_session_mutex);
+    if (session == NULL) {
+        return;
+    }
+
+    // 未啟用的工作階段不會被解析器、回報或接收回調使用，可以直接重設
+    ring_buf_reset(session->rx_rbuf);
+    nus_sink_set_conn(session->sink, conn);
+    k_mutex_lock(&at_session_mutex, K_FOREVER);
+    err = at_session_open(session);
+    k_mutex_unlock(&at_session_mutex);
+    if (err) {
+        nus_sink_set_conn(session->sink, NULL);
+    }
+}
+
+void at_command_nus_disconnected(struct bt_conn *conn) {
+    k_mutex_lock(&at_session_mutex, K_FOREVER);
+    struct at_session *session = at_session_find_nus(conn);
+    if (session != NULL) {
+        session->active = false;
+    }
+    k_mutex_unlock(&at_session_mutex);
+
+    // 解析器可能仍在處理此工作階段，之後的輸出會被 nus_sink 丟棄
+    if (session != NULL) {
+        nus_sink_set_conn(session->sink, NULL);
+    }
+}
+
+// value_reporter 的輸出端：把回報放入每個工作階段的 URC 佇列，佇列滿時丟棄並計數，不會阻塞回報執行緒
+// 放入佇列期間持有 at_session_mutex (只會短暫等待)，避免連線建立/中斷時把回報放進正在重設的工作階段
+static void at_command_publish_urc(const uint8_t *data, size_t len, bool binary) {
+    struct at_urc urc;
+
+    if (len > sizeof(urc.data)) {
+        return;
+    }
+    urc.len = len;
+    urc.binary = binary;
+    memcpy(urc.data, data, len);
+    k_mutex_lock(&at_session_mutex, K_FOREVER);
+    for (size_t i = 0; i < AT_SESSION_NUM; i++) {
+        struct at_session *session = &g_sessions[i];
+        if (!session->active) {
+            continue;
+        }
+        if (k_msgq_put(&session->urc_q, &urc, K_NO_WAIT) != 0) {
+            if (atomic_inc(&session->urc_dropped) == 0) {
+                LOG_WRN("URC queue of session %u full, dropping reports", (unsigned int)i);
+            }
+        }
+    }
+    k_mutex_unlock(&at_session_mutex);
+    at_command_notify();
+}
+
+// 佇列中有 URC 且尚未交給解析器時，觸發非請求讀取事件；只在解析器執行緒中呼叫
+static void at_session_urc_kick(struct at_session *session) {
+    if (session->urc_active || k_msgq_num_used_get(&session->urc_q) == 0) {
+        return;
+    }
+    if (cat_trigger_unsolicited_read(&session->cat, &g_urc_cmd) == CAT_STATUS_OK) {
+        session->urc_active = true;
+    }
+}
+
+int at_command_nus_received(struct bt_conn *conn, const uint8_t *data, size_t len) {
+    k_mutex_lock(&at_session_mutex, K_FOREVER);
+    struct at_session *session = at_session_find_nus(conn);
+    k_mutex_unlock(&at_session_mutex);
+
+    if (session == NULL) {
+        return -ENOTCONN;
+    }
+    // 資料接收與連線回調都在藍牙接收執行緒中執行，它是輸入環形緩衝區唯一的寫入者，
+    // 解析器執行緒是唯一的讀取者，因此放入資料不需要持鎖
+    // 放不下時整筆丟棄，避免把半個命令交給解析器
+    if (ring_buf_space_get(session->rx_rbuf) < len) {
+        return -ENOMEM;
+    }
+    ring_buf_put(session->rx_rbuf, data, len);
+
+    at_command_notify();
+    return 0;
+}
+
 static cat_return_state cmd_help_run(const struct cat_command *cmd) {
     LOG_INF("Execute Help");
     return CAT_RETURN_STATE_PRINT_CMD_LIST_OK;
@@ -183,19 +546,158 @@ static cat_return_state cmd_cgmh_test(const struct cat_command *cmd, uint8_t *da
 static cat_return_state cmd_sysreg_write(const struct cat_command *cmd, const uint8_t *data, const size_t data_size, const size_t args_num) {
     uint32_t result = 0;
 
-    LOG_INF("+SYSREG:%d, %u, %02X,%u,%u\n", g_sysreg_rw, g_sysreg_sensor_id, g_sysreg_reg, g_sysreg_value, g_sysreg_interval);
-    result = value_reporter_set_report_period(g_sysreg_sensor_id, g_sysreg_reg, g_sysreg_interval);
+    // 省略的選用參數回到預設值：秒單位、每個週期都回報
+    if(args_num <= SYSREG_ARG_UNIT)
+    {
+        g_sysreg_unit = VALUE_REPORTER_UNIT_S;
+    }
+    if(args_num <= SYSREG_ARG_DEADBAND)
+    {
+        g_sysreg_deadband = 0;
+    }
+    if(args_num <= SYSREG_ARG_MAX_SILENCE)
+    {
+        g_sysreg_max_silence = 0;
+    }
+    if(args_num <= SYSREG_ARG_MODE)
+    {
+        g_sysreg_mode = 0;
+    }
+    if(g_sysreg_mode > 1)
+    {
+        return CAT_RETURN_STATE_ERROR;
+    }
+
+    LOG_INF("+SYSREG:%d, %u, %02X,%u,%u,%u,%u,%u,%u\n", g_sysreg_rw, g_sysreg_sensor_id, g_sysreg_reg, g_sysreg_value, g_sysreg_interval, g_sysreg_unit, g_sysreg_deadband, g_sysreg_max_silence, g_sysreg_mode);
+    result = value_reporter_set_report_period_unit(g_sysreg_sensor_id, g_sysreg_reg, g_sysreg_interval, g_sysreg_unit);
     if(result != g_sysreg_interval)
     {
         return CAT_RETURN_STATE_ERROR;
     }
 
+    if(value_reporter_set_deadband(g_sysreg_sensor_id, g_sysreg_reg, g_sysreg_deadband, g_sysreg_max_silence) != 0)
+    {
+        return CAT_RETURN_STATE_ERROR;
+    }
+
+    if(value_reporter_set_aggregate(g_sysreg_sensor_id, g_sysreg_reg, g_sysreg_mode == 1) != 0)
+    {
+        return CAT_RETURN_STATE_ERROR;
+    }
+
     return CAT_RETURN_STATE_OK;
 }
 static cat_return_state cmd_sysreg_test(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size) {
     return CAT_RETURN_STATE_OK;
 }
 
+static cat_return_state cmd_syshist_write(const struct cat_command *cmd, const uint8_t *data, const size_t data_size, const size_t args_num) {
+    struct at_session *session = g_current_session;
+
+    if (args_num < 2) {
+        return CAT_RETURN_STATE_ERROR;
+    }
+    session->syshist_sensor_id = g_syshist_sensor_id;
+    session->syshist_reg = g_syshist_reg;
+    // 沒有給 since 時從最舊的樣本開始
+    session->syshist_from_start = (args_num < 3);
+    session->syshist_since = g_syshist_since;
+    return CAT_RETURN_STATE_OK;
+}
+// 每次輸出一批樣本 (文字一行或一個二進位框架)，讀完後回覆 OK
+// 文字格式：+SYSHIST:<sensor_id>,<reg>;<timestamp ms>,<value>;<timestamp ms>,<value>...
+static cat_return_state cmd_syshist_read(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size) {
+    struct at_session *session = g_current_session;
+    struct value_reporter_sample samples[REPORT_FRAME_MAX_SAMPLES];
+    size_t n = value_reporter_history_read(session->syshist_sensor_id, session->syshist_reg,
+                                           session->syshist_from_start ? NULL : &session->syshist_since,
+                                           samples, ARRAY_SIZE(samples));
+    size_t used = 0;
+
+    if (n == 0) {
+        return CAT_RETURN_STATE_OK;
+    }
+
+    if (value_reporter_get_format() == VALUE_REPORTER_FORMAT_BINARY) {
+        int len = value_reporter_make_frame(data, max_data_size, samples, n);
+        if (len < 0) {
+            return CAT_RETURN_STATE_ERROR;
+        }
+        session->syshist_since = samples[n - 1].timestamp + 1;
+        session->syshist_from_start = false;
+        *data_size = len;
+        return CAT_RETURN_STATE_RAW_DATA_NEXT;
+    }
+
+    int written = snprintf((char *)data, max_data_size, "+SYSHIST:%u,%02X", session->syshist_sensor_id, session->syshist_reg);
+    if (written <= 0 || written >= max_data_size) {
+        return CAT_RETURN_STATE_ERROR;
+    }
+    *data_size = written;
+    // 只輸出放得下的樣本，其餘留給下一批
+    for (; used < n; used++) {
+        written = snprintf((char *)&data[*data_size], max_data_size - *data_size, ";%u,%04X", samples[used].timestamp, samples[used].value);
+        if (written <= 0 || written >= max_data_size - *data_size) {
+            data[*data_size] = '\0';
+            break;
+        }
+        *data_size += written;
+    }
+    if (used == 0) {
+        return CAT_RETURN_STATE_ERROR;
+    }
+    session->syshist_since = samples[used - 1].timestamp + 1;
+    session->syshist_from_start = false;
+    return CAT_RETURN_STATE_DATA_NEXT;
+}
+
+static cat_return_state cmd_sysfmt_read(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size) {
+    int written = snprintf((char*)data, max_data_size, "+SYSFMT:%u", (unsigned int)value_reporter_get_format());
+    if (written > 0) {
+        *data_size = written;
+    }
+    return CAT_RETURN_STATE_DATA_OK;
+}
+static cat_return_state cmd_sysfmt_write(const struct cat_command *cmd, const uint8_t *data, const size_t data_size, const size_t args_num) {
+    if (value_reporter_set_format(g_sysfmt_format) != 0) {
+        return CAT_RETURN_STATE_ERROR;
+    }
+    LOG_INF("Report format: %u", g_sysfmt_format);
+    return CAT_RETURN_STATE_OK;
+}
+
+// 接受後解析器送出 "> " 提示，接下來的 <len> 個位元組不經解析，直接從輸入環形緩衝區交給 cmd_xdata_data()
+static cat_return_state cmd_xdata_write(const struct cat_command *cmd, const uint8_t *data, const size_t data_size, const size_t args_num) {
+    struct at_session *session = g_current_session;
+
+    if (cat_data_phase_start(&session->cat, g_xdata_len) != CAT_STATUS_OK) {
+        return CAT_RETURN_STATE_ERROR;
+    }
+    session->xdata_len = 0;
+    session->xdata_crc = 0xFFFF;
+    session->xdata_deadline = k_uptime_get() + CONFIG_AT_DATA_PHASE_TIMEOUT_MS;
+    session->xdata_prompt_deadline = k_uptime_get() + CONFIG_AT_DATA_PHASE_LF_WAIT_MS;
+    return CAT_RETURN_STATE_DATA_PHASE;
+}
+// 每收到一段資料就累加長度與 CRC，並延後逾時
+static cat_return_state cmd_xdata_data(const struct cat_command *cmd, const uint8_t *data, const size_t data_size, const size_t remaining) {
+    struct at_session *session = g_current_session;
+
+    session->xdata_crc = crc16_ccitt(session->xdata_crc, data, data_size);
+    session->xdata_len += data_size;
+    session->xdata_deadline = (remaining > 0) ? k_uptime_get() + CONFIG_AT_DATA_PHASE_TIMEOUT_MS : 0;
+    return CAT_RETURN_STATE_NEXT;
+}
+// 格式：+XDATA:<received len>,<crc16 hex>
+static cat_return_state cmd_xdata_read(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size) {
+    struct at_session *session = g_current_session;
+    int written = snprintf((char *)data, max_data_size, "+XDATA:%u,%04X", session->xdata_len, session->xdata_crc);
+    if (written > 0) {
+        *data_size = written;
+    }
+    return CAT_RETURN_STATE_DATA_OK;
+}
+
 static cat_return_state cmd_xmqttcfg_read(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size) {
     int written = snprintf((char*)data, max_data_size, "+XMQTTCFG:\"%s\",%u,%u", g_mqtt_client_id, g_mqtt_keep_alive, g_mqtt_clean_session);
     if (written > 0) {
@@ -211,32 +713,46 @@ static cat_return_state cmd_xmqttcfg_test(const struct cat_command *cmd, uint8_t
     return CAT_RETURN_STATE_OK;
 }
 
-// --- AT 解析器執行緒 ---
-static void at_parser_thread(void *p1, void *p2, void *p3) {
-    struct cat_object at;
-    
-    struct cat_command_group g_cmd_group_obj = {
-        .cmd = g_cmds,
-        .cmd_num = sizeof(g_cmds) / sizeof(g_cmds[0]),
-    };
-    
-    struct cat_command_group *g_cmd_desc[] = {
-        &g_cmd_group_obj
-    };
+// 每次取出一筆 URC 覆寫整個輸出緩衝區，還有資料時回傳 DATA_NEXT (二進位框架為 RAW_DATA_NEXT)
+// 讓解析器送出後再呼叫一次
+static cat_return_state cmd_urc_read(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size) {
+    struct at_session *session = g_current_session;
+    struct at_urc urc;
+    atomic_val_t dropped = atomic_set(&session->urc_dropped, 0);
+
+    if (dropped > 0) {
+        // 先告知主機有多少筆回報因來不及送出而遺失
+        *data_size = snprintf((char *)data, max_data_size, "+URCDROP:%u", (unsigned int)dropped);
+        return CAT_RETURN_STATE_DATA_NEXT;
+    }
 
-    struct cat_descriptor g_desc = {
-        .cmd_group = g_cmd_desc,
-        .cmd_group_num = sizeof(g_cmd_desc) / sizeof(g_cmd_desc[0]),
-        .buf = (uint8_t *)g_working_buffer,
-        .buf_size = sizeof(g_working_buffer),
-    };
+    if (max_data_size <= AT_URC_MAX_LEN || k_msgq_get(&session->urc_q, &urc, K_NO_WAIT) != 0) {
+        session->urc_active = false;
+        return CAT_RETURN_STATE_OK;
+    }
+    memcpy(data, urc.data, urc.len);
+    *data_size = urc.len;
+    if (urc.binary) {
+        return CAT_RETURN_STATE_RAW_DATA_NEXT;
+    }
+    data[urc.len] = '\0';
+    return CAT_RETURN_STATE_DATA_NEXT;
+}
 
+// --- AT 解析器執行緒 ---
+static void at_parser_thread(void *p1, void *p2, void *p3) {
     if (hmi_uart_init_instance(&at_cmd_uart_instance_data, 115200)) {
         LOG_ERR("UART device not ready!");
         return;
     }
     
-    cat_init(&at, &g_desc, &g_iface, &g_mutex);
+    k_mutex_lock(&at_session_mutex, K_FOREVER);
+    int err = at_session_open(&g_sessions[0]);
+    k_mutex_unlock(&at_session_mutex);
+    if (err) {
+        return;
+    }
+    value_reporter_set_output(at_command_publish_urc);
     LOG_INF("AT Command Parser Thread Started");
     
     // Initial banner
@@ -244,8 +760,83 @@ static void at_parser_thread(void *p1, void *p2, void *p3) {
     LOG_INF("Type AT#HELP to see the command list.\n");
 
     while (!g_quit_flag) {
-        cat_service(&at);
-        k_msleep(1);
+        bool busy = false;
+        int64_t next_deadline = INT64_MAX;
+
+        // 輪流處理每個工作階段，每個最多執行一個批次，避免單一主機佔住解析器
+        for (size_t i = 0; i < AT_SESSION_NUM; i++) {
+            struct at_session *session = &g_sessions[i];
+            bool active;
+
+            // 只在檢查與標記工作階段時持鎖；標記 in_service 後連線中斷也不會被重新分配，
+            // 中斷後的輸出由 nus_sink 直接丟棄
+            k_mutex_lock(&at_session_mutex, K_FOREVER);
+            active = session->active;
+            session->in_service = active;
+            k_mutex_unlock(&at_session_mutex);
+            if (!active) {
+                continue;
+            }
+
+            g_current_session = session;
+            at_session_urc_kick(session);
+            cat_status s = cat_service_run(&session->cat, AT_PARSER_SERVICE_STEPS);
+
+            if ((session->xdata_prompt_deadline != 0) && (k_uptime_get() >= session->xdata_prompt_deadline)) {
+                // 命令列以單獨的 <cr> 結束 (等不到 <lf>)，直接送出 "> " 提示；已經收到下一個位元組時不會有動作
+                session->xdata_prompt_deadline = 0;
+                if (cat_data_phase_prompt(&session->cat) == CAT_STATUS_OK) {
+                    s = CAT_STATUS_BUSY;
+                }
+            }
+            if (session->xdata_deadline != 0) {
+                if (s != CAT_STATUS_OK) {
+                    // 解析器忙碌或輸出阻塞 (例如 "> " 提示還沒送出)，逾時從這次處理之後重新計算
+                    session->xdata_deadline = k_uptime_get() + CONFIG_AT_DATA_PHASE_TIMEOUT_MS;
+                } else if (k_uptime_get() >= session->xdata_deadline) {
+                    // 這次處理已取完所有輸入仍沒有收到新資料，主機在逾時內沒有送完 +XDATA 宣告的資料，
+                    // 丟棄已收到的剩餘資料後結束資料階段並回覆 ERROR
+                    session->xdata_deadline = 0;
+                    if (cat_data_phase_abort(&session->cat) == CAT_STATUS_OK) {
+                        LOG_WRN("+XDATA timed out after %u bytes", session->xdata_len);
+                        s = CAT_STATUS_BUSY;
+                    }
+                }
+            }
+
+            // 輸出阻塞或 hold 狀態時解析器無法自行前進，等待發送完成、cat_hold_exit 或非請求事件的通知；
+            // 只有步數用完時才需要立即再處理一次
+            bool stalled = (s == CAT_STATUS_BUSY) && (cat_is_stalled(&session->cat) != CAT_STATUS_OK);
+
+            // 解析器閒置或停住時立即送出累積的 BLE 回應，仍在處理時只送出等待過久的資料
+            if (session->sink != NULL) {
+                nus_sink_service(session->sink, (s == CAT_STATUS_OK) || stalled);
+            }
+            busy |= (s == CAT_STATUS_BUSY) && !stalled;
+            if (session->xdata_prompt_deadline != 0) {
+                next_deadline = MIN(next_deadline, session->xdata_prompt_deadline);
+            }
+            if (session->xdata_deadline != 0) {
+                next_deadline = MIN(next_deadline, session->xdata_deadline);
+            }
+            if ((session->sink != NULL) && nus_sink_is_blocked(session->sink)) {
+                // 藍牙發送緩衝區沒有完成通知，稍後重試發送
+                next_deadline = MIN(next_deadline, k_uptime_get() + NUS_SINK_RETRY_MS);
+            }
+
+            k_mutex_lock(&at_session_mutex, K_FOREVER);
+            session->in_service = false;
+            k_mutex_unlock(&at_session_mutex);
+        }
+
+        if (!busy) {
+            // 所有工作階段都沒有待處理的輸入或停住，阻塞直到收到資料、發送緩衝區騰出空間、
+            // 非請求事件、hold 結束、資料階段逾時或 BLE 發送重試
+            k_sem_take(&at_parser_sem, (next_deadline == INT64_MAX) ? K_FOREVER : K_TIMEOUT_ABS_MS(next_deadline));
+        } else {
+            // 步數用完，讓出 CPU 給同優先權的執行緒後立即繼續處理
+            k_yield();
+        }
     }
 }
 
@@ -0,0 +1,44 @@
+#ifndef AT_COMMAND_H__
+#define AT_COMMAND_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/bluetooth/conn.h>
+
+/**
+ * @brief 通知 AT 解析器執行緒有新的工作 (收到輸入資料或觸發非請求事件)。
+ *
+ * 解析器執行緒在沒有工作、輸出阻塞或 hold 狀態時會一直阻塞，資料來源放入資料後，
+ * 以及在解析器執行緒以外呼叫 cat_hold_exit() 後必須呼叫此函式。
+ * 可在中斷或其他執行緒環境中呼叫。
+ */
+void at_command_notify(void);
+
+/**
+ * @brief 為新的 BLE NUS 連線建立獨立的 AT 工作階段。
+ *
+ * 每條連線擁有自己的輸入緩衝區、解析器狀態與回應輸出，不會和 UART 或其他連線互相干擾。
+ * 工作階段數量用完時，此連線的輸入會被丟棄。
+ *
+ * @param conn 已建立的 BLE 連線。
+ */
+void at_command_nus_connected(struct bt_conn *conn);
+
+/**
+ * @brief BLE 連線中斷時釋放對應的 AT 工作階段。
+ *
+ * @param conn 已中斷的 BLE 連線。
+ */
+void at_command_nus_disconnected(struct bt_conn *conn);
+
+/**
+ * @brief 將從 BLE NUS 收到的資料放入該連線工作階段的輸入緩衝區，並通知解析器執行緒。
+ *
+ * @param conn 資料來源的 BLE 連線。
+ * @param data 收到的資料。
+ * @param len  資料長度。
+ * @return 0 表示成功，-ENOTCONN 表示連線沒有工作階段，-ENOMEM 表示輸入緩衝區放不下 (整筆資料被丟棄)。
+ */
+int at_command_nus_received(struct bt_conn *conn, const uint8_t *data, size_t len);
+
+#endif // AT_COMMAND_H__
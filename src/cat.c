@@ -23,19 +23,19 @@ SOFTWARE.
 */
 
 #include "cat.h"
+#include "numfmt.h"
 
-#include <stdio.h>
 #include <string.h>
 #include <assert.h>
 #include <zephyr/logging/log.h>
-#define CAT_CMD_STATE_NOT_MATCH (0)
-#define CAT_CMD_STATE_PARTIAL_MATCH (1U)
-#define CAT_CMD_STATE_FULL_MATCH (2U)
 
 #define CAT_WRITE_STATE_BEFORE (0)
 #define CAT_WRITE_STATE_MAIN_BUFFER (1U)
 #define CAT_WRITE_STATE_AFTER (2U)
 
+/* number of buffer bytes converted to ascii hex per output copy */
+#define CAT_HEX_FORMAT_CHUNK_SIZE (16U)
+
 LOG_MODULE_REGISTER(cat_module, LOG_LEVEL_INF);
 
 static inline char* get_atcmd_buf(struct cat_object *self)
@@ -75,6 +75,8 @@ static void reset_state(struct cat_object *self)
         }
         self->cmd = NULL;
         self->cmd_type = CAT_CMD_TYPE_NONE;
+        self->data_left = 0;
+        self->data_abort_flag = false;
 }
 
 static void unsolicited_reset_state(struct cat_object *self)
@@ -295,6 +297,7 @@ static void start_flush_io_buffer(struct cat_object *self, cat_state state_after
 
         self->position = 0;
         self->write_buf = get_new_line_chars(self);
+        self->write_len = 0;
         self->write_state = CAT_WRITE_STATE_BEFORE;
         self->write_state_after = state_after;
         self->state = CAT_STATE_FLUSH_IO_WRITE_WAIT;
@@ -306,6 +309,7 @@ static void unsolicited_start_flush_io_buffer(struct cat_object *self, cat_unsol
 
         self->unsolicited_fsm.position = 0;
         self->unsolicited_fsm.write_buf = get_new_line_chars(self);
+        self->unsolicited_fsm.write_len = 0;
         self->unsolicited_fsm.write_state = CAT_WRITE_STATE_BEFORE;
         self->unsolicited_fsm.write_state_after = state_after;
         self->unsolicited_fsm.state = CAT_UNSOLICITED_STATE_FLUSH_IO_WRITE_WAIT;
@@ -317,11 +321,42 @@ static void start_flush_io_buffer_raw(struct cat_object *self, cat_state state_a
 
         self->position = 0;
         self->write_buf = get_atcmd_buf(self);
+        self->write_len = 0;
         self->write_state = CAT_WRITE_STATE_AFTER;
         self->write_state_after = state_after;
         self->state = CAT_STATE_FLUSH_IO_WRITE_WAIT;
 }
 
+static void start_flush_io_buffer_raw_len(struct cat_object *self, size_t len, cat_state state_after)
+{
+        assert(self != NULL);
+
+        if (len == 0) {
+                self->state = state_after;
+                return;
+        }
+
+        start_flush_io_buffer_raw(self, state_after);
+        self->write_len = len;
+}
+
+static void unsolicited_start_flush_io_buffer_raw_len(struct cat_object *self, size_t len, cat_unsolicited_state state_after)
+{
+        assert(self != NULL);
+
+        if (len == 0) {
+                self->unsolicited_fsm.state = state_after;
+                return;
+        }
+
+        self->unsolicited_fsm.position = 0;
+        self->unsolicited_fsm.write_buf = get_unsolicited_buf(self);
+        self->unsolicited_fsm.write_len = len;
+        self->unsolicited_fsm.write_state = CAT_WRITE_STATE_AFTER;
+        self->unsolicited_fsm.write_state_after = state_after;
+        self->unsolicited_fsm.state = CAT_UNSOLICITED_STATE_FLUSH_IO_WRITE_WAIT;
+}
+
 static void ack_error(struct cat_object *self)
 {
         assert(self != NULL);
@@ -408,13 +443,92 @@ static int print_string_to_buf(struct cat_object *self, const char *str, cat_fsm
         return print_nstring_to_buf(self, str, strlen(str), fsm);
 }
 
+static int read_input_char(struct cat_object *self, char *ch)
+{
+        assert(self != NULL);
+        assert(ch != NULL);
+
+        if (self->io->read_block == NULL) {
+                if (self->unread_flag != false) {
+                        self->unread_flag = false;
+                        *ch = self->current_char;
+                        return 1;
+                }
+                return self->io->read(ch);
+        }
+
+        /* consume input block in place, and release it only when fully parsed */
+        if (self->read_pos >= self->read_len) {
+                self->read_len = self->io->read_block(&self->read_buf, self->read_pos);
+                self->read_pos = 0;
+                if (self->read_len == 0)
+                        return 0;
+        }
+
+        *ch = self->read_buf[self->read_pos++];
+        return 1;
+}
+
+static void unread_input_char(struct cat_object *self)
+{
+        assert(self != NULL);
+
+        if (self->io->read_block == NULL) {
+                /* char is kept in current_char and returned by next read */
+                self->unread_flag = true;
+                return;
+        }
+
+        /* char is still in current input block, which is not released yet */
+        assert(self->read_pos > 0);
+        self->read_pos--;
+}
+
+static size_t read_input_block(struct cat_object *self, const char **buf, size_t max_len)
+{
+        size_t len = 0;
+
+        assert(self != NULL);
+        assert(buf != NULL);
+
+        if (self->io->read_block == NULL) {
+                /* without block interface, chunk is collected in working buffer */
+                if (max_len > get_atcmd_buf_size(self))
+                        max_len = get_atcmd_buf_size(self);
+                *buf = get_atcmd_buf(self);
+                if ((self->unread_flag != false) && (max_len > 0)) {
+                        self->unread_flag = false;
+                        get_atcmd_buf(self)[len++] = self->current_char;
+                }
+                while ((len < max_len) && (self->io->read(&get_atcmd_buf(self)[len]) != 0))
+                        len++;
+                return len;
+        }
+
+        if (self->read_pos >= self->read_len) {
+                self->read_len = self->io->read_block(&self->read_buf, self->read_pos);
+                self->read_pos = 0;
+                if (self->read_len == 0)
+                        return 0;
+        }
+
+        /* pass part of input block in place, it is released with next read_block call */
+        len = self->read_len - self->read_pos;
+        if (len > max_len)
+                len = max_len;
+        *buf = &self->read_buf[self->read_pos];
+        self->read_pos += len;
+        return len;
+}
+
 static int read_cmd_char(struct cat_object *self)
 {
         assert(self != NULL);
 
-        if (self->io->read(&self->current_char) == 0)
+        if (read_input_char(self, &self->current_char) == 0)
                 return 0;
 
+        self->cr_flag = (self->current_char == '\r');
         if (self->state != CAT_STATE_PARSE_COMMAND_ARGS)
                 self->current_char = to_upper(self->current_char);
 
@@ -425,25 +539,83 @@ static int read_cmd_char(struct cat_object *self)
 
 static struct cat_command const* get_command_by_index(struct cat_object *self, size_t index)
 {
-        size_t i, j;
+        assert(self != NULL);
+        assert(index < self->commands_num);
+
+        return self->cmd_table[index];
+}
+
+static bool test_map_bit(uint32_t const *map, size_t index)
+{
+        return (map[index >> 5] & ((uint32_t)1 << (index & 31))) != 0;
+}
+
+static void write_map_bit(uint32_t *map, size_t index, bool value)
+{
+        if (value != false) {
+                map[index >> 5] |= (uint32_t)1 << (index & 31);
+        } else {
+                map[index >> 5] &= ~((uint32_t)1 << (index & 31));
+        }
+}
+
+static void build_command_table(struct cat_object *self)
+{
+        size_t i, j, k;
         struct cat_command_group const *cmd_group;
 
         assert(self != NULL);
-        assert(index < self->commands_num);
 
-        j = 0;
+        memset(self->cmd_disable_map, 0, sizeof(self->cmd_disable_map));
+        memset(self->group_disable_map, 0, sizeof(self->group_disable_map));
+        memset(self->disable_map, 0, sizeof(self->disable_map));
+
+        k = 0;
         for (i = 0; i < self->desc->cmd_group_num; i++) {
                 cmd_group = self->desc->cmd_group[i];
+                write_map_bit(self->group_disable_map, i, cmd_group->disable);
 
-                if (index >= j + cmd_group->cmd_num) {
-                        j += cmd_group->cmd_num;
-                        continue;
+                for (j = 0; j < cmd_group->cmd_num; j++) {
+                        self->cmd_table[k] = &cmd_group->cmd[j];
+                        self->cmd_name_len[k] = (uint8_t)strlen(cmd_group->cmd[j].name);
+                        write_map_bit(self->cmd_disable_map, k, cmd_group->cmd[j].disable);
+                        write_map_bit(self->disable_map, k, (cmd_group->disable != false) || (cmd_group->cmd[j].disable != false));
+                        k++;
                 }
-
-                return &cmd_group->cmd[index - j];
         }
+}
 
-        return NULL;
+static int compare_cmd_names(const char *a, const char *b)
+{
+        char ch_a;
+        char ch_b;
+
+        do {
+                ch_a = to_upper(*a++);
+                ch_b = to_upper(*b++);
+        } while ((ch_a == ch_b) && (ch_a != '\0'));
+
+        return (int)(unsigned char)ch_a - (int)(unsigned char)ch_b;
+}
+
+static void build_command_index(struct cat_object *self)
+{
+        size_t i, j;
+        struct cat_command const *cmd;
+
+        assert(self != NULL);
+
+        /* insertion sort is enough here, it runs only once and tables are small */
+        for (i = 0; i < self->commands_num; i++) {
+                cmd = get_command_by_index(self, i);
+
+                j = i;
+                while ((j > 0) && (compare_cmd_names(get_command_by_index(self, self->cmd_index[j - 1])->name, cmd->name) > 0)) {
+                        self->cmd_index[j] = self->cmd_index[j - 1];
+                        j--;
+                }
+                self->cmd_index[j] = (uint16_t)i;
+        }
 }
 
 static void unsolicited_init(struct cat_object *self)
@@ -455,7 +627,18 @@ static void unsolicited_init(struct cat_object *self)
         unsolicited_reset_state(self);
 }
 
-void cat_init(struct cat_object *self, const struct cat_descriptor *desc, const struct cat_io_interface *io, const struct cat_mutex_interface *mutex)
+static size_t get_var_buf_need(const struct cat_command *cmd)
+{
+        size_t i;
+        size_t size = 0;
+
+        for (i = 0; i < cmd->var_num; i++)
+                size += CAT_VAR_SLOT_SIZE(cmd->var[i].data_size);
+
+        return size;
+}
+
+cat_status cat_init(struct cat_object *self, const struct cat_descriptor *desc, const struct cat_io_interface *io, const struct cat_mutex_interface *mutex)
 {
         size_t i, j;
         struct cat_command_group const *cmd_group;
@@ -467,6 +650,10 @@ void cat_init(struct cat_object *self, const struct cat_descriptor *desc, const
         assert(desc->cmd_group != NULL);
         assert(desc->cmd_group_num > 0);
 
+        /* variables scratch slots are accessed as 32-bit words */
+        if ((desc->var_buf != NULL) && (((uintptr_t)desc->var_buf % sizeof(uint32_t)) != 0))
+                return CAT_STATUS_ERROR;
+
         self->commands_num = 0;
         for (i = 0; i < desc->cmd_group_num; i++) {
                 cmd_group = desc->cmd_group[i];
@@ -478,6 +665,11 @@ void cat_init(struct cat_object *self, const struct cat_descriptor *desc, const
 
                 for (j = 0; j < cmd_group->cmd_num; j++) {
                         assert(cmd_group->cmd[j].name != NULL);
+                        /* names lengths are cached in 8-bit table */
+                        if (strlen(cmd_group->cmd[j].name) > UINT8_MAX)
+                                return CAT_STATUS_ERROR;
+                        if ((desc->var_buf != NULL) && (get_var_buf_need(&cmd_group->cmd[j]) > desc->var_buf_size))
+                                return CAT_STATUS_ERROR;
                         if (cmd_group->cmd[j].implicit_write != false) {
                                 assert(cmd_group->cmd[j].read == NULL);
                                 assert(cmd_group->cmd[j].run == NULL);
@@ -487,18 +679,34 @@ void cat_init(struct cat_object *self, const struct cat_descriptor *desc, const
         }
 
         assert(desc->buf != NULL);
-        assert(desc->buf_size * 4U >= self->commands_num);
+
+        /* command index, command table and disable bitmaps have fixed size, refuse descriptors which does not fit in them */
+        if ((self->commands_num > CAT_COMMAND_INDEX_SIZE) || (desc->cmd_group_num > CAT_COMMAND_INDEX_SIZE))
+                return CAT_STATUS_ERROR;
 
         self->desc = desc;
         self->io = io;
         self->mutex = mutex;
         self->hold_state_flag = false;
         self->hold_exit_status = 0;
+        self->data_left = 0;
+        self->data_error_flag = false;
+        self->data_abort_flag = false;
         self->implicit_write_flag = false;
+        self->io_blocked_flag = false;
+        self->read_buf = NULL;
+        self->read_len = 0;
+        self->read_pos = 0;
+        self->unread_flag = false;
+
+        build_command_table(self);
+        build_command_index(self);
 
         reset_state(self);
 
         unsolicited_init(self);
+
+        return CAT_STATUS_OK;
 }
 
 static cat_status error_state(struct cat_object *self)
@@ -522,13 +730,10 @@ static cat_status error_state(struct cat_object *self)
 
 static void prepare_parse_command(struct cat_object *self)
 {
-        uint8_t val = (CAT_CMD_STATE_PARTIAL_MATCH << 0) | (CAT_CMD_STATE_PARTIAL_MATCH << 2) | (CAT_CMD_STATE_PARTIAL_MATCH << 4) |
-                      (CAT_CMD_STATE_PARTIAL_MATCH << 6);
-
         assert(self != NULL);
 
-        memset(get_atcmd_buf(self), val, get_atcmd_buf_size(self));
-
+        self->match_begin = 0;
+        self->match_end = self->commands_num;
         self->index = 0;
         self->length = 0;
         self->cmd_type = CAT_CMD_TYPE_RUN;
@@ -575,22 +780,6 @@ static int is_valid_cmd_name_char(const char ch)
         return (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || (ch == '+') || (ch == '#') || (ch == '$') || (ch == '@') || (ch == '_') || (ch == '%') || (ch == '&');
 }
 
-static int is_valid_dec_char(const char ch)
-{
-        return (ch >= '0' && ch <= '9');
-}
-
-static int is_valid_hex_char(const char ch)
-{
-        return (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'F');
-}
-
-static uint8_t convert_hex_char_to_value(const char ch)
-{
-        return ((ch >= '0') && (ch <= '9')) ? (uint8_t)(ch - '0') : (uint8_t)(ch - 'A' + 10U);
-}
-
-
 static void end_processing_with_error(struct cat_object *self, cat_fsm_type fsm)
 {
         assert(self != NULL);
@@ -751,101 +940,68 @@ static cat_status parse_command(struct cat_object *self)
 
 static bool is_command_disable(struct cat_object *self, size_t index)
 {
-        size_t i, j;
-        struct cat_command_group const *cmd_group;
-
         assert(self != NULL);
         assert(index < self->commands_num);
 
-        j = 0;
-        for (i = 0; i < self->desc->cmd_group_num; i++) {
-                cmd_group = self->desc->cmd_group[i];
-
-                if (index >= j + cmd_group->cmd_num) {
-                        j += cmd_group->cmd_num;
-                        continue;
-                }
-
-                if (cmd_group->disable != false)
-                        return true;
-
-                if (cmd_group->cmd[index - j].disable != false)
-                        return true;
-
-                break;
-        }
-
-        return false;
+        return test_map_bit(self->disable_map, index);
 }
 
-static uint8_t get_cmd_state(struct cat_object *self, size_t i)
+static char get_indexed_name_char(struct cat_object *self, size_t i, size_t pos)
 {
-        uint8_t s;
-
         assert(self != NULL);
         assert(i < self->commands_num);
 
-        if (is_command_disable(self, i) != false)
-        {
-                LOG_DBG("CAT_STATE_SEARCH_COMMAND");
-                return CAT_CMD_STATE_NOT_MATCH;
-        }
-
-        s = get_atcmd_buf(self)[i >> 2];
-        s >>= (i % 4) << 1;
-        s &= 0x03;
-
-        return s;
+        return to_upper(get_command_by_index(self, self->cmd_index[i])->name[pos]);
 }
 
-static void set_cmd_state(struct cat_object *self, size_t i, uint8_t state)
+static size_t search_name_char_bound(struct cat_object *self, size_t begin, size_t end, size_t pos, char ch, bool upper)
 {
-        uint8_t s;
-        size_t n;
-        uint8_t k;
+        size_t mid;
+        unsigned char s;
+
+        assert(self != NULL);
+
+        /* all commands in range share the same pos-long prefix, so they are sorted by char at pos */
+        while (begin < end) {
+                mid = begin + ((end - begin) >> 1);
+                s = (unsigned char)get_indexed_name_char(self, mid, pos);
 
-        n = i >> 2;
-        k = ((i % 4) << 1);
+                if ((s < (unsigned char)ch) || ((upper != false) && (s == (unsigned char)ch))) {
+                        begin = mid + 1;
+                } else {
+                        end = mid;
+                }
+        }
 
-        s = get_atcmd_buf(self)[n];
-        s &= ~(0x03 << k);
-        s |= (state & 0x03) << k;
-        get_atcmd_buf(self)[n] = s;
+        return begin;
 }
 
 static cat_status update_command(struct cat_object *self)
 {
         assert(self != NULL);
 
-        struct cat_command const *cmd = get_command_by_index(self, self->index);
-        size_t cmd_name_len;
-
-        if (get_cmd_state(self, self->index) != CAT_CMD_STATE_NOT_MATCH) {
-                cmd_name_len = strlen(cmd->name);
-
-                if (self->length > cmd_name_len) {
-                        set_cmd_state(self, self->index, CAT_CMD_STATE_NOT_MATCH);
-                } else if (to_upper(cmd->name[self->length - 1]) != self->current_char) {
-                        set_cmd_state(self, self->index, CAT_CMD_STATE_NOT_MATCH);
-                } else if (self->length == cmd_name_len) {
-                        set_cmd_state(self, self->index, CAT_CMD_STATE_FULL_MATCH);
+        size_t pos = self->length - 1;
+        size_t i;
+        struct cat_command const *cmd;
 
-                        if (cmd->implicit_write != false)
-                                self->implicit_write_flag = true;
-                }
-        }
+        self->match_end = search_name_char_bound(self, self->match_begin, self->match_end, pos, self->current_char, true);
+        self->match_begin = search_name_char_bound(self, self->match_begin, self->match_end, pos, self->current_char, false);
+        self->state = CAT_STATE_PARSE_COMMAND_CHAR;
 
-        if (++self->index >= self->commands_num) {
-                self->index = 0;
+        /* shorter names are sorted first, so full matches are at the beginning of range */
+        for (i = self->match_begin; i < self->match_end; i++) {
+                if (self->cmd_name_len[self->cmd_index[i]] != self->length)
+                        break;
+                cmd = get_command_by_index(self, self->cmd_index[i]);
+                if (is_command_disable(self, self->cmd_index[i]) != false)
+                        continue;
 
-                if (self->implicit_write_flag == false) {
-                        self->state = CAT_STATE_PARSE_COMMAND_CHAR;
-                } else {
+                if (cmd->implicit_write != false) {
                         self->cmd_type = CAT_CMD_TYPE_WRITE;
                         prepare_search_command(self);
                         self->state = CAT_STATE_SEARCH_COMMAND;
-                        self->implicit_write_flag = false;
                 }
+                break;
         }
 
         return CAT_STATUS_BUSY;
@@ -939,29 +1095,31 @@ static cat_status search_command(struct cat_object *self)
 {
         assert(self != NULL);
 
-        uint8_t cmd_state = get_cmd_state(self, self->index);
+        size_t i;
+        struct cat_command const *cmd;
 
-        if (cmd_state != CAT_CMD_STATE_NOT_MATCH) {
-                if (cmd_state == CAT_CMD_STATE_PARTIAL_MATCH) {
-                        if ((self->cmd != NULL) && ((self->index + 1) == self->commands_num)) {
-                                self->state = (self->current_char == '\n') ? CAT_STATE_COMMAND_NOT_FOUND : CAT_STATE_ERROR;
-                                return CAT_STATUS_BUSY;
-                        }
-                        self->cmd = get_command_by_index(self, self->index);
-                        self->partial_cntr++;
-                } else if (cmd_state == CAT_CMD_STATE_FULL_MATCH) {
-                        self->cmd = get_command_by_index(self, self->index);
-                        self->state = CAT_STATE_COMMAND_FOUND;
-                        return CAT_STATUS_BUSY;
+        for (i = self->match_begin; i < self->match_end; i++) {
+                if (is_command_disable(self, self->cmd_index[i]) != false)
+                        continue;
+
+                cmd = get_command_by_index(self, self->cmd_index[i]);
+                if (self->cmd_name_len[self->cmd_index[i]] == self->length) {
+                        self->cmd = cmd;
+                        self->partial_cntr = 1;
+                        break;
                 }
+
+                if (self->cmd == NULL)
+                        self->cmd = cmd;
+                /* ambiguous abbreviation, no need to look further */
+                if (++self->partial_cntr > 1)
+                        break;
         }
 
-        if (++self->index >= self->commands_num) {
-                if (self->cmd == NULL) {
-                        self->state = (self->current_char == '\n') ? CAT_STATE_COMMAND_NOT_FOUND : CAT_STATE_ERROR;
-                } else {
-                        self->state = (self->partial_cntr == 1) ? CAT_STATE_COMMAND_FOUND : CAT_STATE_COMMAND_NOT_FOUND;
-                }
+        if (self->cmd == NULL) {
+                self->state = (self->current_char == '\n') ? CAT_STATE_COMMAND_NOT_FOUND : CAT_STATE_ERROR;
+        } else {
+                self->state = (self->partial_cntr == 1) ? CAT_STATE_COMMAND_FOUND : CAT_STATE_COMMAND_NOT_FOUND;
         }
 
         return CAT_STATUS_BUSY;
@@ -1048,6 +1206,14 @@ static cat_status command_found(struct cat_object *self)
         case CAT_CMD_TYPE_WRITE:
                 self->length = 0;
                 get_atcmd_buf(self)[0] = 0;
+                self->position = 0;
+                self->index = 0;
+                self->args_quote_flag = false;
+                self->args_escape_flag = false;
+                self->var_buf_pos = 0;
+                self->args_stream_flag = (self->cmd->only_test == false) && (is_variables_access_possible(self, self->cmd, CAT_VAR_ACCESS_WRITE_ONLY) != false);
+                if (self->args_stream_flag != false)
+                        self->var = &self->cmd->var[0];
                 self->state = CAT_STATE_PARSE_COMMAND_ARGS;
                 break;
         default:
@@ -1066,163 +1232,107 @@ static cat_status command_not_found(struct cat_object *self)
         return CAT_STATUS_BUSY;
 }
 
-static int parse_int_decimal(struct cat_object *self, int64_t *ret)
+static void *get_var_data(struct cat_object *self)
 {
-        assert(self != NULL);
-        assert(ret != NULL);
+        /* with scratch buffer variables are updated only after whole command line is accepted */
+        if (self->desc->var_buf != NULL)
+                return &self->desc->var_buf[self->var_buf_pos + sizeof(uint32_t)];
+
+        return self->var->data;
+}
 
+static int parse_num_end(struct cat_object *self, size_t digits)
+{
         char ch;
-        int64_t val = 0;
-        int64_t sign = 0;
-        int ok = 0;
 
-        while (1) {
-                ch = get_atcmd_buf(self)[self->position++];
+        assert(self != NULL);
 
-                if ((ok != 0) && ((ch == 0) || (ch == ','))) {
-                        val *= sign;
-                        *ret = val;
-                        return (ch == ',') ? 1 : 0;
-                }
+        if (digits == 0)
+                return -1;
 
-                if (sign == 0) {
-                        if (ch == '-') {
-                                sign = -1;
-                        } else if (ch == '+') {
-                                sign = 1;
-                        } else if (is_valid_dec_char(ch) != 0) {
-                                sign = 1;
-                                val = ch - '0';
-                                ok = 1;
-                        } else {
-                                return -1;
-                        }
-                } else {
-                        if (is_valid_dec_char(ch) != 0) {
-                                ok = 1;
-                                val *= 10;
-                                val += ch - '0';
-                        } else {
-                                return -1;
-                        }
-                }
-        }
+        self->position += digits;
+        ch = get_atcmd_buf(self)[self->position++];
+        if ((ch != 0) && (ch != ','))
+                return -1;
 
-        return -1;
+        return (ch == ',') ? 1 : 0;
 }
 
-static int parse_uint_decimal(struct cat_object *self, uint64_t *ret)
+static int parse_int_decimal(struct cat_object *self, int64_t *ret)
 {
         assert(self != NULL);
         assert(ret != NULL);
 
         char ch;
         uint64_t val = 0;
-        int ok = 0;
-
-        while (1) {
-                ch = get_atcmd_buf(self)[self->position++];
-
-                if ((ok != 0) && ((ch == 0) || (ch == ','))) {
-                        *ret = val;
-                        return (ch == ',') ? 1 : 0;
-                }
+        bool negative = false;
+        int stat;
 
-                if (is_valid_dec_char(ch) != 0) {
-                        ok = 1;
-                        val *= 10;
-                        val += ch - '0';
-                } else {
-                        return -1;
-                }
+        ch = get_atcmd_buf(self)[self->position];
+        if ((ch == '-') || (ch == '+')) {
+                negative = (ch == '-');
+                self->position++;
         }
 
-        return -1;
+        stat = parse_num_end(self, numfmt_dec_to_u64(&get_atcmd_buf(self)[self->position], self->length - self->position, &val));
+        if (stat < 0)
+                return -1;
+
+        /* out of int64 range values are rejected later by range validation */
+        if (val > (uint64_t)INT64_MAX)
+                val = (uint64_t)INT64_MAX;
+        *ret = (negative != false) ? -(int64_t)val : (int64_t)val;
+        return stat;
 }
 
-static int parse_num_hexadecimal(struct cat_object *self, uint64_t *ret)
+static int parse_uint_decimal(struct cat_object *self, uint64_t *ret)
 {
         assert(self != NULL);
         assert(ret != NULL);
 
-        char ch;
-        uint64_t val = 0;
-        int state = 0;
-
-        while (1) {
-                ch = get_atcmd_buf(self)[self->position++];
-                ch = to_upper(ch);
+        return parse_num_end(self, numfmt_dec_to_u64(&get_atcmd_buf(self)[self->position], self->length - self->position, ret));
+}
 
-                if ((state >= 3) && ((ch == 0) || (ch == ','))) {
-                        *ret = val;
-                        return (ch == ',') ? 1 : 0;
-                }
+static int parse_num_hexadecimal(struct cat_object *self, uint64_t *ret)
+{
+        assert(self != NULL);
+        assert(ret != NULL);
 
-                if (state == 0) {
-                        if (ch != '0')
-                                return -1;
-                        state = 1;
-                } else if (state == 1) {
-                        if (ch != 'X')
-                                return -1;
-                        state = 2;
-                } else if (state >= 2) {
-                        if (is_valid_hex_char(ch) != 0) {
-                                state = 3;
-                                val <<= 4;
-                                val += convert_hex_char_to_value(ch);
-                        } else {
-                                return -1;
-                        }
-                }
-        }
+        if (get_atcmd_buf(self)[self->position] != '0')
+                return -1;
+        if (to_upper(get_atcmd_buf(self)[self->position + 1]) != 'X')
+                return -1;
+        self->position += 2;
 
-        return -1;
+        return parse_num_end(self, numfmt_hex_to_u64(&get_atcmd_buf(self)[self->position], self->length - self->position, ret));
 }
 
 static int parse_buffer_hexadecimal(struct cat_object *self)
 {
         assert(self != NULL);
 
+        uint8_t *data;
+        size_t len;
+        size_t digits;
         char ch;
-        uint8_t byte = 0;
-        int state = 0;
-        size_t size = 0;
-
-        while (1) {
-                ch = get_atcmd_buf(self)[self->position++];
-                ch = to_upper(ch);
-
-                if ((size > 0) && (state == 0) && ((ch == 0) || (ch == ','))) {
-                        if (self->var->access == CAT_VAR_ACCESS_READ_ONLY) {
-                                self->write_size = 0;
-                        } else {
-                                self->write_size = size;
-                        }
-                        return (ch == ',') ? 1 : 0;
-                }
-
-                if (is_valid_hex_char(ch) == 0)
-                        return -1;
 
-                byte <<= 4;
-                byte += convert_hex_char_to_value(ch);
+        /* one digit more than the buffer holds is enough to detect an oversized payload */
+        len = self->length - self->position;
+        if (len > self->var->data_size * 2 + 1)
+                len = self->var->data_size * 2 + 1;
 
-                if (state != 0) {
-                        if (size >= self->var->data_size)
-                                return -1;
-                        if (self->var->access == CAT_VAR_ACCESS_READ_ONLY) {
-                                size++;
-                        } else {
-                                ((uint8_t *)(self->var->data))[size++] = byte;
-                        }
-                        byte = 0;
-                }
+        data = (self->var->access == CAT_VAR_ACCESS_READ_ONLY) ? NULL : (uint8_t *)get_var_data(self);
+        digits = numfmt_hex_to_bytes(data, &get_atcmd_buf(self)[self->position], len);
+        if ((digits == 0) || ((digits & 1U) != 0))
+                return -1;
 
-                state = !state;
-        }
+        self->position += digits;
+        ch = get_atcmd_buf(self)[self->position++];
+        if ((ch != 0) && (ch != ','))
+                return -1;
 
-        return -1;
+        self->write_size = (data == NULL) ? 0 : digits / 2;
+        return (ch == ',') ? 1 : 0;
 }
 
 static int parse_buffer_string(struct cat_object *self)
@@ -1258,7 +1368,7 @@ static int parse_buffer_string(struct cat_object *self)
                         if (self->var->access == CAT_VAR_ACCESS_READ_ONLY) {
                                 size++;
                         } else {
-                                ((uint8_t *)(self->var->data))[size++] = ch;
+                                ((uint8_t *)get_var_data(self))[size++] = ch;
                         }
                         break;
                 case 2:
@@ -1280,7 +1390,7 @@ static int parse_buffer_string(struct cat_object *self)
                         if (self->var->access == CAT_VAR_ACCESS_READ_ONLY) {
                                 size++;
                         } else {
-                                ((uint8_t *)(self->var->data))[size++] = ch;
+                                ((uint8_t *)get_var_data(self))[size++] = ch;
                         }
                         state = 1;
                         break;
@@ -1291,7 +1401,7 @@ static int parse_buffer_string(struct cat_object *self)
                                 if (self->var->access == CAT_VAR_ACCESS_READ_ONLY) {
                                         self->write_size = 0;
                                 } else {
-                                        ((uint8_t *)(self->var->data))[size] = 0;
+                                        ((uint8_t *)get_var_data(self))[size] = 0;
                                         self->write_size = size;
                                 }
                                 return (ch == ',') ? 1 : 0;
@@ -1318,17 +1428,17 @@ static int validate_int_range(struct cat_object *self, int64_t val)
         case 1:
                 if ((val < INT8_MIN) || (val > INT8_MAX))
                         return -1;
-                *(int8_t *)(self->var->data) = val;
+                *(int8_t *)get_var_data(self) = val;
                 break;
         case 2:
                 if ((val < INT16_MIN) || (val > INT16_MAX))
                         return -1;
-                *(int16_t *)(self->var->data) = val;
+                *(int16_t *)get_var_data(self) = val;
                 break;
         case 4:
                 if ((val < INT32_MIN) || (val > INT32_MAX))
                         return -1;
-                *(int32_t *)(self->var->data) = val;
+                *(int32_t *)get_var_data(self) = val;
                 break;
         default:
                 return -1;
@@ -1348,17 +1458,17 @@ static int validate_uint_range(struct cat_object *self, uint64_t val)
         case 1:
                 if (val > UINT8_MAX)
                         return -1;
-                *(uint8_t *)(self->var->data) = val;
+                *(uint8_t *)get_var_data(self) = val;
                 break;
         case 2:
                 if (val > UINT16_MAX)
                         return -1;
-                *(uint16_t *)(self->var->data) = val;
+                *(uint16_t *)get_var_data(self) = val;
                 break;
         case 4:
                 if (val > UINT32_MAX)
                         return -1;
-                *(uint32_t *)(self->var->data) = val;
+                *(uint32_t *)get_var_data(self) = val;
                 break;
         default:
                 return -1;
@@ -1367,110 +1477,111 @@ static int validate_uint_range(struct cat_object *self, uint64_t val)
         return 0;
 }
 
-static cat_status parse_write_args(struct cat_object *self)
+static int parse_write_var(struct cat_object *self)
 {
         int64_t val;
-        cat_status stat;
+        int stat;
 
         assert(self != NULL);
 
         switch (self->var->type) {
         case CAT_VAR_INT_DEC:
                 stat = parse_int_decimal(self, &val);
-                if (stat < 0) {
-                        ack_error(self);
-                        return CAT_STATUS_BUSY;
-                }
-                if (validate_int_range(self, val) != 0) {
-                        ack_error(self);
-                        return CAT_STATUS_BUSY;
-                }
+                if ((stat < 0) || (validate_int_range(self, val) != 0))
+                        return -1;
                 break;
         case CAT_VAR_UINT_DEC:
                 stat = parse_uint_decimal(self, (uint64_t *)&val);
-                if (stat < 0) {
-                        ack_error(self);
-                        return CAT_STATUS_BUSY;
-                }
-                if (validate_uint_range(self, val) != 0) {
-                        ack_error(self);
-                        return CAT_STATUS_BUSY;
-                }
+                if ((stat < 0) || (validate_uint_range(self, val) != 0))
+                        return -1;
                 break;
         case CAT_VAR_NUM_HEX:
                 stat = parse_num_hexadecimal(self, (uint64_t *)&val);
-                if (stat < 0) {
-                        ack_error(self);
-                        return CAT_STATUS_BUSY;
-                }
-                if (validate_uint_range(self, val) != 0) {
-                        ack_error(self);
-                        return CAT_STATUS_BUSY;
-                }
+                if ((stat < 0) || (validate_uint_range(self, val) != 0))
+                        return -1;
                 break;
         case CAT_VAR_BUF_HEX:
                 stat = parse_buffer_hexadecimal(self);
-                if (stat < 0) {
-                        ack_error(self);
-                        return CAT_STATUS_BUSY;
-                }
+                if (stat < 0)
+                        return -1;
                 break;
         case CAT_VAR_BUF_STRING:
                 stat = parse_buffer_string(self);
-                if (stat < 0) {
-                        ack_error(self);
-                        return CAT_STATUS_BUSY;
-                }
+                if (stat < 0)
+                        return -1;
                 break;
         default:
-                return CAT_STATUS_ERROR;
+                return -2;
         }
 
-        if ((self->var->write != NULL) && (self->var->write(self->var, self->write_size) != 0)) {
-                ack_error(self);
-                return CAT_STATUS_BUSY;
+        if (self->desc->var_buf != NULL) {
+                /* keep decoded size in slot, variable write handler is called when variables are updated */
+                *(uint32_t *)&self->desc->var_buf[self->var_buf_pos] = self->write_size;
+                self->var_buf_pos += CAT_VAR_SLOT_SIZE(self->var->data_size);
+                return stat;
         }
 
-        if ((++self->index < self->cmd->var_num) && (stat > 0)) {
-                self->var = &self->cmd->var[self->index];
-                return CAT_STATUS_BUSY;
-        }
+        if ((self->var->write != NULL) && (self->var->write(self->var, self->write_size) != 0))
+                return -1;
 
-        if (stat > 0) {
-                ack_error(self);
-                return CAT_STATUS_BUSY;
-        }
+        return stat;
+}
 
-        if ((self->cmd->need_all_vars != false) && (self->index != self->cmd->var_num)) {
-                ack_error(self);
-                return CAT_STATUS_BUSY;
-        }
+static int update_write_vars(struct cat_object *self)
+{
+        size_t i;
+        size_t pos = 0;
+        size_t size;
+        uint8_t *slot;
+        struct cat_variable const *var;
 
-        if (self->cmd->write == NULL) {
-                ack_ok(self);
-                return CAT_STATUS_BUSY;
+        assert(self != NULL);
+
+        if (self->desc->var_buf == NULL)
+                return 0;
+
+        /* copy decoded arguments from scratch buffer in the same order they were received */
+        for (i = 0; i < self->index; i++) {
+                var = &self->cmd->var[i];
+                slot = &self->desc->var_buf[pos];
+                pos += CAT_VAR_SLOT_SIZE(var->data_size);
+
+                size = *(uint32_t *)slot;
+                if (var->access != CAT_VAR_ACCESS_READ_ONLY)
+                        memcpy(var->data, &slot[sizeof(uint32_t)], (var->type == CAT_VAR_BUF_STRING) ? size + 1 : size);
+
+                if ((var->write != NULL) && (var->write(var, size) != 0))
+                        return -1;
         }
 
-        self->state = CAT_STATE_WRITE_LOOP;
-        return CAT_STATUS_BUSY;
+        return 0;
 }
 
-static int print_format_num(struct cat_object *self, char *fmt, uint32_t val, cat_fsm_type fsm)
+static int print_format_int(struct cat_object *self, int32_t val, cat_fsm_type fsm)
 {
-        int written;
-        size_t len;
+        char str[NUMFMT_I32_DEC_MAX_LEN];
 
-        assert(self != NULL);
-        assert(fsm < CAT_FSM_TYPE__TOTAL_NUM);
+        return print_nstring_to_buf(self, str, numfmt_i32_to_dec(str, val), fsm);
+}
 
-        len = get_left_buffer_space_by_fsm(self, fsm);
-        written = snprintf(get_current_buffer_by_fsm(self, fsm), len, fmt, val);
+static int print_format_uint(struct cat_object *self, uint32_t val, cat_fsm_type fsm)
+{
+        char str[NUMFMT_U32_DEC_MAX_LEN];
 
-        if ((written < 0) || ((size_t)written >= len))
-                return -1;
+        return print_nstring_to_buf(self, str, numfmt_u32_to_dec(str, val), fsm);
+}
 
-        move_position_by_fsm(self, written, fsm);
-        return 0;
+static int print_format_hex(struct cat_object *self, const char *prefix, uint32_t val, size_t digits, cat_fsm_type fsm)
+{
+        char str[2 + NUMFMT_U32_HEX_MAX_LEN];
+        size_t len = strlen(prefix);
+
+        assert(len <= 2);
+        assert(digits <= NUMFMT_U32_HEX_MAX_LEN);
+
+        memcpy(str, prefix, len);
+        numfmt_u32_to_hex(&str[len], val, digits);
+        return print_nstring_to_buf(self, str, len + digits, fsm);
 }
 
 static int format_int_decimal(struct cat_object *self, cat_fsm_type fsm)
@@ -1499,7 +1610,7 @@ static int format_int_decimal(struct cat_object *self, cat_fsm_type fsm)
         if (var->access == CAT_VAR_ACCESS_WRITE_ONLY)
                 val = 0;
 
-        if (print_format_num(self, "%d", val, fsm) != 0)
+        if (print_format_int(self, val, fsm) != 0)
                 return -1;
 
         return 0;
@@ -1531,7 +1642,7 @@ static int format_uint_decimal(struct cat_object *self, cat_fsm_type fsm)
         if (var->access == CAT_VAR_ACCESS_WRITE_ONLY)
                 val = 0;
 
-        if (print_format_num(self, "%u", val, fsm) != 0)
+        if (print_format_uint(self, val, fsm) != 0)
                 return -1;
 
         return 0;
@@ -1540,7 +1651,6 @@ static int format_uint_decimal(struct cat_object *self, cat_fsm_type fsm)
 static int format_num_hexadecimal(struct cat_object *self, cat_fsm_type fsm)
 {
         uint32_t val;
-        char fstr[8];
 
         assert(self != NULL);
         assert(fsm < CAT_FSM_TYPE__TOTAL_NUM);
@@ -1550,15 +1660,12 @@ static int format_num_hexadecimal(struct cat_object *self, cat_fsm_type fsm)
         switch (var->data_size) {
         case 1:
                 val = *(uint8_t *)var->data;
-                strcpy(fstr, "0x%02X");
                 break;
         case 2:
                 val = *(uint16_t *)var->data;
-                strcpy(fstr, "0x%04X");
                 break;
         case 4:
                 val = *(uint32_t *)var->data;
-                strcpy(fstr, "0x%08X");
                 break;
         default:
                 return -1;
@@ -1567,7 +1674,7 @@ static int format_num_hexadecimal(struct cat_object *self, cat_fsm_type fsm)
         if (var->access == CAT_VAR_ACCESS_WRITE_ONLY)
                 val = 0;
 
-        if (print_format_num(self, fstr, val, fsm) != 0)
+        if (print_format_hex(self, "0x", val, var->data_size * 2, fsm) != 0)
                 return -1;
 
         return 0;
@@ -1575,24 +1682,29 @@ static int format_num_hexadecimal(struct cat_object *self, cat_fsm_type fsm)
 
 static int format_buffer_hexadecimal(struct cat_object *self, cat_fsm_type fsm)
 {
+        char str[CAT_HEX_FORMAT_CHUNK_SIZE * 2];
         size_t i;
+        size_t n;
         uint8_t *buf;
-        uint8_t val;
 
         assert(self != NULL);
         assert(fsm < CAT_FSM_TYPE__TOTAL_NUM);
 
         struct cat_variable *var = get_var_by_fsm(self, fsm);
 
+        if (var->access == CAT_VAR_ACCESS_WRITE_ONLY)
+                memset(str, '0', sizeof(str));
+
         buf = var->data;
-        for (i = 0; i < var->data_size; i++) {
-                if (var->access == CAT_VAR_ACCESS_WRITE_ONLY) {
-                        val = 0;
-                } else {
-                        val = buf[i];
-                }
+        for (i = 0; i < var->data_size; i += n) {
+                n = var->data_size - i;
+                if (n > CAT_HEX_FORMAT_CHUNK_SIZE)
+                        n = CAT_HEX_FORMAT_CHUNK_SIZE;
+
+                if (var->access != CAT_VAR_ACCESS_WRITE_ONLY)
+                        numfmt_bytes_to_hex(str, &buf[i], n);
 
-                if (print_format_num(self, "%02X", val, fsm) != 0)
+                if (print_nstring_to_buf(self, str, n * 2, fsm) != 0)
                         return -1;
         }
         return 0;
@@ -1880,6 +1992,43 @@ static cat_status format_test_args(struct cat_object *self, cat_fsm_type fsm)
         return CAT_STATUS_BUSY;
 }
 
+static int update_args_stream(struct cat_object *self)
+{
+        assert(self != NULL);
+
+        if (self->args_escape_flag != false) {
+                self->args_escape_flag = false;
+                return 0;
+        }
+
+        if (self->args_quote_flag != false) {
+                if (self->current_char == '\\') {
+                        self->args_escape_flag = true;
+                } else if (self->current_char == '"') {
+                        self->args_quote_flag = false;
+                }
+                return 0;
+        }
+
+        if (self->current_char == '"') {
+                self->args_quote_flag = true;
+                return 0;
+        }
+
+        if (self->current_char != ',')
+                return 0;
+
+        /* decode argument as soon as its delimiter arrives, so only the last one is left after end of line */
+        if (parse_write_var(self) <= 0)
+                return -1;
+
+        if (++self->index >= self->cmd->var_num)
+                return -1;
+
+        self->var = &self->cmd->var[self->index];
+        return 0;
+}
+
 static cat_status parse_command_args(struct cat_object *self)
 {
         assert(self != NULL);
@@ -1895,11 +2044,9 @@ static cat_status parse_command_args(struct cat_object *self)
                         ack_error(self);
                         break;
                 }
-                if (is_variables_access_possible(self, self->cmd, CAT_VAR_ACCESS_WRITE_ONLY) != false) {
+                if (self->args_stream_flag != false) {
+                        /* preceding arguments are already decoded, only the last one is left */
                         self->state = CAT_STATE_PARSE_WRITE_ARGS;
-                        self->position = 0;
-                        self->index = 0;
-                        self->var = &self->cmd->var[self->index];
                         break;
                 }
                 if (self->cmd->write == NULL) {
@@ -1927,7 +2074,10 @@ static cat_status parse_command_args(struct cat_object *self)
                         get_atcmd_buf(self)[self->length] = 0;
                 } else {
                         self->state = CAT_STATE_ERROR;
+                        break;
                 }
+                if ((self->args_stream_flag != false) && (update_args_stream(self) != 0))
+                        self->state = CAT_STATE_ERROR;
                 break;
         }
         return CAT_STATUS_BUSY;
@@ -2085,7 +2235,7 @@ static void print_cmd_list(struct cat_object *self)
 
         switch (self->cmd_type) {
         case CAT_CMD_TYPE_NONE:
-                if (self->cmd->disable != false) {
+                if (test_map_bit(self->cmd_disable_map, self->index) != false) {
                         if (cmd_list_next_cmd(self) == false)
                                 ack_ok(self);
                         break;
@@ -2147,6 +2297,167 @@ static void print_cmd_list(struct cat_object *self)
         }
 }
 
+static void send_data_phase_prompt(struct cat_object *self)
+{
+        assert(self != NULL);
+
+        self->position = 0;
+        if ((print_string_to_buf(self, get_new_line_chars(self), CAT_FSM_TYPE_ATCMD) != 0) ||
+            (print_string_to_buf(self, "> ", CAT_FSM_TYPE_ATCMD) != 0)) {
+                ack_error(self);
+                return;
+        }
+        start_flush_io_buffer_raw_len(self, self->position, CAT_STATE_DATA_PHASE);
+}
+
+static void start_data_phase(struct cat_object *self)
+{
+        assert(self != NULL);
+
+        /* write handler did not announce payload with cat_data_phase_start */
+        if (self->data_left == 0) {
+                ack_error(self);
+                return;
+        }
+
+        /* <lf> following <cr> which ended command line belongs to line terminator, */
+        /* prompt is sent after it is known whether it follows, so it never becomes payload */
+        if (self->cr_flag != false) {
+                self->cr_flag = false;
+                self->state = CAT_STATE_DATA_PHASE_WAIT_LF;
+                return;
+        }
+
+        send_data_phase_prompt(self);
+}
+
+static cat_status process_data_phase_wait_lf(struct cat_object *self)
+{
+        assert(self != NULL);
+
+        /* aborted before prompt, no payload was requested from host */
+        if (self->data_abort_flag != false) {
+                self->state = CAT_STATE_DATA_PHASE;
+                return CAT_STATUS_BUSY;
+        }
+
+        if (read_input_char(self, &self->current_char) == 0)
+                return CAT_STATUS_OK;
+
+        if (self->current_char != '\n')
+                unread_input_char(self);
+
+        send_data_phase_prompt(self);
+        return CAT_STATUS_BUSY;
+}
+
+static cat_status process_data_phase(struct cat_object *self)
+{
+        const char *chunk;
+        size_t len;
+
+        assert(self != NULL);
+
+        /* whole payload passed or data phase aborted */
+        if (self->data_left == 0) {
+                if (self->data_error_flag != false) {
+                        ack_error(self);
+                } else {
+                        ack_ok(self);
+                }
+                return CAT_STATUS_BUSY;
+        }
+
+        len = read_input_block(self, &chunk, self->data_left);
+        if (len == 0) {
+                /* aborted data phase ends when already received payload is drained */
+                if (self->data_abort_flag != false) {
+                        self->data_left = 0;
+                        return CAT_STATUS_BUSY;
+                }
+                return CAT_STATUS_OK;
+        }
+
+        self->data_left -= len;
+        if (self->data_error_flag != false)
+                return CAT_STATUS_BUSY;
+
+        switch (self->cmd->data(self->cmd, (const uint8_t *)chunk, len, self->data_left)) {
+        case CAT_RETURN_STATE_OK:
+        case CAT_RETURN_STATE_NEXT:
+                break;
+        default:
+                /* rest of payload is still consumed to keep command stream in sync */
+                self->data_error_flag = true;
+                break;
+        }
+
+        return CAT_STATUS_BUSY;
+}
+
+cat_status cat_data_phase_start(struct cat_object *self, size_t len)
+{
+        assert(self != NULL);
+
+        if ((self->state != CAT_STATE_WRITE_LOOP) || (self->cmd == NULL) || (self->cmd->data == NULL) || (len == 0))
+                return CAT_STATUS_ERROR;
+
+        self->data_left = len;
+        self->data_error_flag = false;
+        self->data_abort_flag = false;
+        return CAT_STATUS_OK;
+}
+
+cat_status cat_data_phase_prompt(struct cat_object *self)
+{
+        cat_status s = CAT_STATUS_ERROR;
+
+        assert(self != NULL);
+
+        if ((self->mutex != NULL) && (self->mutex->lock() != 0))
+                return CAT_STATUS_ERROR_MUTEX_LOCK;
+
+        if ((self->state == CAT_STATE_DATA_PHASE_WAIT_LF) && (self->data_abort_flag == false)) {
+                send_data_phase_prompt(self);
+                s = CAT_STATUS_OK;
+        }
+
+        if ((self->mutex != NULL) && (self->mutex->unlock() != 0))
+                return CAT_STATUS_ERROR_MUTEX_UNLOCK;
+
+        return s;
+}
+
+static cat_status data_phase_abort(struct cat_object *self)
+{
+        assert(self != NULL);
+
+        if ((self->data_left == 0) || (self->state == CAT_STATE_WRITE_LOOP) || (self->data_abort_flag != false))
+                return CAT_STATUS_ERROR;
+
+        /* payload bytes already received (up to announced length) are discarded, so they are not parsed as commands */
+        self->data_error_flag = true;
+        self->data_abort_flag = true;
+        return CAT_STATUS_OK;
+}
+
+cat_status cat_data_phase_abort(struct cat_object *self)
+{
+        cat_status s;
+
+        assert(self != NULL);
+
+        if ((self->mutex != NULL) && (self->mutex->lock() != 0))
+                return CAT_STATUS_ERROR_MUTEX_LOCK;
+
+        s = data_phase_abort(self);
+
+        if ((self->mutex != NULL) && (self->mutex->unlock() != 0))
+                return CAT_STATUS_ERROR_MUTEX_UNLOCK;
+
+        return s;
+}
+
 static cat_status process_write_loop(struct cat_object *self)
 {
         assert(self != NULL);
@@ -2162,6 +2473,9 @@ static cat_status process_write_loop(struct cat_object *self)
         case CAT_RETURN_STATE_HOLD:
                 enable_hold_state(self);
                 break;
+        case CAT_RETURN_STATE_DATA_PHASE:
+                start_data_phase(self);
+                break;
         case CAT_RETURN_STATE_HOLD_EXIT_OK:
         case CAT_RETURN_STATE_HOLD_EXIT_ERROR:
         case CAT_RETURN_STATE_ERROR:
@@ -2174,6 +2488,51 @@ static cat_status process_write_loop(struct cat_object *self)
         return CAT_STATUS_BUSY;
 }
 
+static cat_status parse_write_args(struct cat_object *self)
+{
+        int stat;
+
+        assert(self != NULL);
+
+        stat = parse_write_var(self);
+        if (stat == -2)
+                return CAT_STATUS_ERROR;
+        if (stat < 0) {
+                ack_error(self);
+                return CAT_STATUS_BUSY;
+        }
+
+        if ((++self->index < self->cmd->var_num) && (stat > 0)) {
+                self->var = &self->cmd->var[self->index];
+                return CAT_STATUS_BUSY;
+        }
+
+        if (stat > 0) {
+                ack_error(self);
+                return CAT_STATUS_BUSY;
+        }
+
+        if ((self->cmd->need_all_vars != false) && (self->index != self->cmd->var_num)) {
+                ack_error(self);
+                return CAT_STATUS_BUSY;
+        }
+
+        if (update_write_vars(self) != 0) {
+                ack_error(self);
+                return CAT_STATUS_BUSY;
+        }
+
+        if (self->cmd->write == NULL) {
+                ack_ok(self);
+                return CAT_STATUS_BUSY;
+        }
+
+        /* call write handler in the same step as variables update, */
+        /* so other parser object sharing the variables cannot change them in between */
+        self->state = CAT_STATE_WRITE_LOOP;
+        return process_write_loop(self);
+}
+
 static cat_status process_run_loop(struct cat_object *self)
 {
         assert(self != NULL);
@@ -2254,6 +2613,18 @@ static cat_status process_read_loop(struct cat_object *self, cat_fsm_type fsm)
                         assert(false);
                 }
                 break;
+        case CAT_RETURN_STATE_RAW_DATA_NEXT:
+                switch (fsm) {
+                case CAT_FSM_TYPE_ATCMD:
+                        start_flush_io_buffer_raw_len(self, self->position, CAT_STATE_AFTER_FLUSH_FORMAT_READ_ARGS);
+                        break;
+                case CAT_FSM_TYPE_UNSOLICITED:
+                        unsolicited_start_flush_io_buffer_raw_len(self, self->unsolicited_fsm.position, CAT_UNSOLICITED_STATE_AFTER_FLUSH_FORMAT_READ_ARGS);
+                        break;
+                default:
+                        assert(false);
+                }
+                break;
         case CAT_RETURN_STATE_NEXT:
                 start_processing_format_read_args(self, fsm);
                 break;
@@ -2427,6 +2798,85 @@ struct cat_command_group const* cat_search_command_group_by_name(struct cat_obje
         return NULL;
 }
 
+static cat_status set_command_disable(struct cat_object *self, struct cat_command const *cmd, bool disable)
+{
+        size_t i, j, k;
+        struct cat_command_group const *cmd_group;
+
+        k = 0;
+        for (i = 0; i < self->desc->cmd_group_num; i++) {
+                cmd_group = self->desc->cmd_group[i];
+
+                if ((cmd < cmd_group->cmd) || (cmd >= cmd_group->cmd + cmd_group->cmd_num)) {
+                        k += cmd_group->cmd_num;
+                        continue;
+                }
+
+                j = k + (size_t)(cmd - cmd_group->cmd);
+                write_map_bit(self->cmd_disable_map, j, disable);
+                write_map_bit(self->disable_map, j, (disable != false) || (test_map_bit(self->group_disable_map, i) != false));
+                return CAT_STATUS_OK;
+        }
+
+        return CAT_STATUS_ERROR;
+}
+
+cat_status cat_set_command_disable(struct cat_object *self, struct cat_command const *cmd, bool disable)
+{
+        cat_status s;
+
+        assert(self != NULL);
+        assert(cmd != NULL);
+
+        if ((self->mutex != NULL) && (self->mutex->lock() != 0))
+                return CAT_STATUS_ERROR_MUTEX_LOCK;
+
+        s = set_command_disable(self, cmd, disable);
+
+        if ((self->mutex != NULL) && (self->mutex->unlock() != 0))
+                return CAT_STATUS_ERROR_MUTEX_UNLOCK;
+
+        return s;
+}
+
+static cat_status set_command_group_disable(struct cat_object *self, struct cat_command_group const *cmd_group, bool disable)
+{
+        size_t i, j, k;
+
+        k = 0;
+        for (i = 0; i < self->desc->cmd_group_num; i++) {
+                if (self->desc->cmd_group[i] != cmd_group) {
+                        k += self->desc->cmd_group[i]->cmd_num;
+                        continue;
+                }
+
+                write_map_bit(self->group_disable_map, i, disable);
+                for (j = k; j < k + cmd_group->cmd_num; j++)
+                        write_map_bit(self->disable_map, j, (disable != false) || (test_map_bit(self->cmd_disable_map, j) != false));
+                return CAT_STATUS_OK;
+        }
+
+        return CAT_STATUS_ERROR;
+}
+
+cat_status cat_set_command_group_disable(struct cat_object *self, struct cat_command_group const *cmd_group, bool disable)
+{
+        cat_status s;
+
+        assert(self != NULL);
+        assert(cmd_group != NULL);
+
+        if ((self->mutex != NULL) && (self->mutex->lock() != 0))
+                return CAT_STATUS_ERROR_MUTEX_LOCK;
+
+        s = set_command_group_disable(self, cmd_group, disable);
+
+        if ((self->mutex != NULL) && (self->mutex->unlock() != 0))
+                return CAT_STATUS_ERROR_MUTEX_UNLOCK;
+
+        return s;
+}
+
 struct cat_variable const* cat_search_variable_by_name(struct cat_object *self, struct cat_command const *cmd, const char *name)
 {
         size_t i;
@@ -2462,11 +2912,40 @@ static cat_status unsolicited_process_io_write_wait(struct cat_object *self)
         return CAT_STATUS_BUSY;
 }
 
-static cat_status process_io_write(struct cat_object *self)
+static bool is_write_segment_end(const char *buf, size_t position, size_t write_len)
+{
+        /* raw data segments are delimited by length, text segments by null char */
+        return (write_len != 0) ? (position >= write_len) : (buf[position] == '\0');
+}
+
+static void write_io_segment(struct cat_object *self, const char *buf, size_t *position, size_t write_len)
 {
-        char ch = self->write_buf[self->position];
+        size_t len;
+
+        assert(self != NULL);
+        assert(buf != NULL);
+        assert(position != NULL);
 
-        if (ch == '\0') {
+        /* hand whole rest of segment at once, when transport supports it */
+        if (self->io->write_block != NULL) {
+                len = (write_len != 0) ? (write_len - *position) : strlen(&buf[*position]);
+                len = self->io->write_block((const uint8_t *)&buf[*position], len);
+        } else {
+                len = (self->io->write(buf[*position]) == 1) ? 1 : 0;
+        }
+
+        if (len == 0) {
+                self->io_blocked_flag = true;
+                return;
+        }
+
+        *position += len;
+}
+
+static cat_status process_io_write(struct cat_object *self)
+{
+        if (is_write_segment_end(self->write_buf, self->position, self->write_len) != false) {
+                self->write_len = 0;
                 switch (self->write_state) {
                 case CAT_WRITE_STATE_BEFORE:
                         self->position = 0;
@@ -2487,18 +2966,14 @@ static cat_status process_io_write(struct cat_object *self)
                 return CAT_STATUS_BUSY;
         }
 
-        if (self->io->write(ch) != 1)
-                return CAT_STATUS_BUSY;
-
-        self->position++;
+        write_io_segment(self, self->write_buf, &self->position, self->write_len);
         return CAT_STATUS_BUSY;
 }
 
 static cat_status unsolicited_process_io_write(struct cat_object *self)
 {
-        char ch = self->unsolicited_fsm.write_buf[self->unsolicited_fsm.position];
-
-        if (ch == '\0') {
+        if (is_write_segment_end(self->unsolicited_fsm.write_buf, self->unsolicited_fsm.position, self->unsolicited_fsm.write_len) != false) {
+                self->unsolicited_fsm.write_len = 0;
                 switch (self->unsolicited_fsm.write_state) {
                 case CAT_WRITE_STATE_BEFORE:
                         self->unsolicited_fsm.position = 0;
@@ -2517,10 +2992,7 @@ static cat_status unsolicited_process_io_write(struct cat_object *self)
                 return CAT_STATUS_BUSY;
         }
 
-        if (self->io->write(ch) != 1)
-                return CAT_STATUS_BUSY;
-
-        self->unsolicited_fsm.position++;
+        write_io_segment(self, self->unsolicited_fsm.write_buf, &self->unsolicited_fsm.position, self->unsolicited_fsm.write_len);
         return CAT_STATUS_BUSY;
 }
 
@@ -2578,15 +3050,14 @@ static bool is_unsolicited_fsm_busy(struct cat_object *self)
         return (self->unsolicited_fsm.state != CAT_UNSOLICITED_STATE_IDLE);
 }
 
-cat_status cat_service(struct cat_object *self)
+static cat_status service_step(struct cat_object *self)
 {
         cat_status s;
         cat_status unsolicited_stat;
 
         assert(self != NULL);
 
-        if ((self->mutex != NULL) && (self->mutex->lock() != 0))
-                return CAT_STATUS_ERROR_MUTEX_LOCK;
+        self->io_blocked_flag = false;
 
         unsolicited_stat = unsolicited_events_service(self);
 
@@ -2677,6 +3148,12 @@ cat_status cat_service(struct cat_object *self)
                 print_cmd_list(self);
                 s = CAT_STATUS_BUSY;
                 break;
+        case CAT_STATE_DATA_PHASE_WAIT_LF:
+                s = process_data_phase_wait_lf(self);
+                break;
+        case CAT_STATE_DATA_PHASE:
+                s = process_data_phase(self);
+                break;
         default:
                 s = CAT_STATUS_ERROR_UNKNOWN_STATE;
                 break;
@@ -2686,6 +3163,71 @@ cat_status cat_service(struct cat_object *self)
                 s = CAT_STATUS_BUSY;
         }
 
+        return s;
+}
+
+static bool is_service_stalled(struct cat_object *self)
+{
+        assert(self != NULL);
+
+        if (self->io_blocked_flag != false)
+                return true;
+
+        /* nothing to do until hold exit, unless unsolicited events are waiting */
+        if ((self->state == CAT_STATE_HOLD) && (self->hold_exit_status == 0))
+                return (is_unsolicited_fsm_busy(self) == false) && (is_unsolicited_buffer_empty(self) != false);
+
+        return false;
+}
+
+cat_status cat_service(struct cat_object *self)
+{
+        cat_status s;
+
+        assert(self != NULL);
+
+        if ((self->mutex != NULL) && (self->mutex->lock() != 0))
+                return CAT_STATUS_ERROR_MUTEX_LOCK;
+
+        s = service_step(self);
+
+        if ((self->mutex != NULL) && (self->mutex->unlock() != 0))
+                return CAT_STATUS_ERROR_MUTEX_UNLOCK;
+
+        return s;
+}
+
+cat_status cat_service_run(struct cat_object *self, size_t max_steps)
+{
+        cat_status s;
+
+        assert(self != NULL);
+        assert(max_steps > 0);
+
+        if ((self->mutex != NULL) && (self->mutex->lock() != 0))
+                return CAT_STATUS_ERROR_MUTEX_LOCK;
+
+        do {
+                s = service_step(self);
+        } while ((s == CAT_STATUS_BUSY) && (--max_steps > 0) && (is_service_stalled(self) == false));
+
+        if ((self->mutex != NULL) && (self->mutex->unlock() != 0))
+                return CAT_STATUS_ERROR_MUTEX_UNLOCK;
+
+        return s;
+}
+
+cat_status cat_is_stalled(struct cat_object *self)
+{
+        cat_status s;
+
+        assert(self != NULL);
+
+        if ((self->mutex != NULL) && (self->mutex->lock() != 0))
+                return CAT_STATUS_ERROR_MUTEX_LOCK;
+
+        s = (is_service_stalled(self) != false) ? CAT_STATUS_BUSY : CAT_STATUS_OK;
+
         if ((self->mutex != NULL) && (self->mutex->unlock() != 0))
                 return CAT_STATUS_ERROR_MUTEX_UNLOCK;
 
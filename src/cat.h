@@ -42,6 +42,17 @@ struct cat_variable;
 #define CAT_UNSOLICITED_CMD_BUFFER_SIZE     ((size_t)(1))
 #endif
 
+#ifndef CAT_COMMAND_INDEX_SIZE
+/* maximum number of registered commands covered by command name index (can by override externally during compilation) */
+#define CAT_COMMAND_INDEX_SIZE     ((size_t)(64))
+#endif
+
+/* number of 32-bit words in per command bitmaps */
+#define CAT_COMMAND_MAP_WORDS     ((CAT_COMMAND_INDEX_SIZE + 31) / 32)
+
+/* size of one variable slot in variables scratch buffer (decoded size followed by data padded to 32-bit) */
+#define CAT_VAR_SLOT_SIZE(data_size)     (sizeof(uint32_t) + (((size_t)(data_size) + 3U) & ~(size_t)3U))
+
 /* enum type with variable type definitions */
 typedef enum {
         CAT_VAR_INT_DEC = 0, /* decimal encoded signed integer variable */
@@ -119,6 +130,8 @@ typedef enum {
         CAT_RETURN_STATE_HOLD_EXIT_OK, /* exit from hold state with OK response */
         CAT_RETURN_STATE_HOLD_EXIT_ERROR, /* exit from hold state with ERROR response */
         CAT_RETURN_STATE_PRINT_CMD_LIST_OK, /* print commands list followed by ok acknowledge (only in TEST and RUN) */
+        CAT_RETURN_STATE_RAW_DATA_NEXT, /* send data_size raw bytes of current data buffer (without new line chars) and go to next callback iteration (only in READ) */
+        CAT_RETURN_STATE_DATA_PHASE, /* send data prompt and pass raw payload announced by cat_data_phase_start to data handler, then ok/error acknowledge (only in WRITE) */
 } cat_return_state;
 
 /**
@@ -184,6 +197,24 @@ typedef cat_return_state (*cat_cmd_run_handler)(const struct cat_command *cmd);
  * */
 typedef cat_return_state (*cat_cmd_test_handler)(const struct cat_command *cmd, uint8_t *data, size_t *data_size, const size_t max_data_size);
 
+/**
+ * Data phase chunk handler (raw payload after AT+CMD=)
+ * 
+ * This callback function is called with consecutive chunks of raw payload,
+ * after write handler announced payload length with cat_data_phase_start and returned CAT_RETURN_STATE_DATA_PHASE.
+ * Payload is not escaped nor buffered in working buffer, chunks point directly to input stream blocks,
+ * so data pointer is valid only during callback.
+ * This handler is optional, it is needed only by commands which use data phase.
+ * 
+ * @param cmd - pointer to struct descriptor of processed command
+ * @param data - pointer to chunk of raw payload
+ * @param data_size - length of chunk
+ * @param remaining - number of payload bytes left after this chunk (0 - last chunk)
+ * @return CAT_RETURN_STATE_NEXT or CAT_RETURN_STATE_OK - chunk accepted, ok acknowledge is sent after last chunk
+ *         other values - payload rejected, rest of it is consumed without calling handler, then error acknowledge
+ * */
+typedef cat_return_state (*cat_cmd_data_handler)(const struct cat_command *cmd, const uint8_t *data, const size_t data_size, const size_t remaining);
+
 /* enum type with main at parser fsm state */
 typedef enum {
         CAT_STATE_ERROR = -1,
@@ -212,6 +243,8 @@ typedef enum {
         CAT_STATE_AFTER_FLUSH_FORMAT_READ_ARGS,
         CAT_STATE_AFTER_FLUSH_FORMAT_TEST_ARGS,
         CAT_STATE_PRINT_CMD,
+        CAT_STATE_DATA_PHASE_WAIT_LF,
+        CAT_STATE_DATA_PHASE,
 } cat_state;
 
 /* enum type with type of command request */
@@ -228,6 +261,8 @@ typedef enum {
 struct cat_io_interface {
         int (*write)(char ch); /* write char to output stream. return 1 if byte wrote successfully. */
         int (*read)(char *ch); /* read char from input stream. return 1 if byte read successfully. */
+        size_t (*write_block)(const uint8_t *buf, size_t len); /* write block to output stream (optional, can be NULL). return number of bytes accepted. */
+        size_t (*read_block)(const char **buf, size_t consumed); /* release consumed bytes of previous block and get next contiguous block from input stream (optional, can be NULL). return block length, 0 if no data. */
 };
 
 /* structure with mutex interface functions */
@@ -245,13 +280,14 @@ struct cat_command {
         cat_cmd_read_handler read; /* read command handler */
         cat_cmd_run_handler run; /* run command handler */
         cat_cmd_test_handler test; /* test command handler */
+        cat_cmd_data_handler data; /* data phase chunk handler (optional, used with CAT_RETURN_STATE_DATA_PHASE) */
 
         struct cat_variable const *var; /* pointer to array of variables assiocated with this command */
         size_t var_num; /* number of variables in array */
 
         bool need_all_vars; /* flag to need all vars parsing */
         bool only_test; /* flag to disable read/write/run commands (only test auto description) */
-        bool disable; /* flag to completely disable command */
+        bool disable; /* flag to completely disable command (initial state, use cat_set_command_disable at runtime) */
         bool implicit_write; /* flag to mark command as implicit write */
 };
 
@@ -261,7 +297,7 @@ struct cat_command_group {
         struct cat_command const *cmd; /* pointer to array of commands descriptor */
         size_t cmd_num; /* number of commands in array */
 
-        bool disable; /* flag to completely disable all commands in group */
+        bool disable; /* flag to completely disable all commands in group (initial state, use cat_set_command_group_disable at runtime) */
 };
 
 /* structure with at command parser descriptor */
@@ -276,6 +312,12 @@ struct cat_descriptor {
         /* then the buf will be divided into two smaller buffers */
         uint8_t *unsolicited_buf; /* pointer to unsolicited working buffer (used to parse command argument) */
         size_t unsolicited_buf_size; /* unsolicited working buffer length */
+
+        /* optional variables scratch buffer (32-bit aligned), if configured write arguments are decoded into it */
+        /* while they are received and copied into variables only after whole command line is accepted, */
+        /* so parser objects sharing one commands table cannot see each other partially received arguments */
+        uint8_t *var_buf; /* pointer to variables scratch buffer */
+        size_t var_buf_size; /* variables scratch buffer length (at least sum of CAT_VAR_SLOT_SIZE of variables of any command) */
 };
 
 /* strcuture with unsolicited command buffered infos */
@@ -317,6 +359,7 @@ struct cat_unsolicited_fsm {
         cat_cmd_type cmd_type; /* type of command request */
 
         char const *write_buf; /* working buffer pointer used for asynch writing to io */
+        size_t write_len; /* length of raw data in write buffer (0 - write until null char) */
         int write_state; /* before, data, after flush io write state */
         cat_unsolicited_state write_state_after; /* parser state to set after flush io write */
 
@@ -339,19 +382,41 @@ struct cat_object {
         size_t write_size; /* size of parsed buffer hex or buffer string */
         size_t commands_num; /* computed total number of registered commands */
 
+        struct cat_command const *cmd_table[CAT_COMMAND_INDEX_SIZE]; /* flat table of registered commands (built once in cat_init) */
+        uint8_t cmd_name_len[CAT_COMMAND_INDEX_SIZE]; /* registered command names lengths */
+        uint16_t cmd_index[CAT_COMMAND_INDEX_SIZE]; /* commands indexes sorted by upper-cased name (built once in cat_init) */
+        uint32_t cmd_disable_map[CAT_COMMAND_MAP_WORDS]; /* bitmap of commands disabled by own flag */
+        uint32_t group_disable_map[CAT_COMMAND_MAP_WORDS]; /* bitmap of disabled command groups */
+        uint32_t disable_map[CAT_COMMAND_MAP_WORDS]; /* bitmap of commands disabled by own or group flag */
+        size_t match_begin; /* first position in cmd_index of commands matching parsed name prefix */
+        size_t match_end; /* position after last in cmd_index of commands matching parsed name prefix */
+
         struct cat_command const *cmd; /* pointer to current command descriptor */
         struct cat_variable const *var; /* pointer to current variable descriptor */
         cat_cmd_type cmd_type; /* type of command request */
 
         char current_char; /* current received char from input stream */
+        const char *read_buf; /* current input block returned by read_block */
+        size_t read_len; /* length of current input block */
+        size_t read_pos; /* position of next char to read from current input block */
+        bool unread_flag; /* flag that current_char was returned to input stream (used without read_block interface) */
         cat_state state; /* current fsm state */
-        bool cr_flag; /* flag for detect <cr> char in input string */
+        bool cr_flag; /* flag for detect <cr> char in input string (last received command char was <cr>) */
         bool hold_state_flag; /* status of hold state (independent from fsm states) */
         int hold_exit_status; /* hold exit parameter with status */
+        size_t data_left; /* number of raw payload bytes left in data phase (0 - no data phase) */
+        bool data_error_flag; /* flag that data phase payload was rejected or aborted */
+        bool data_abort_flag; /* flag that data phase was aborted, it ends when received payload is drained */
         char const *write_buf; /* working buffer pointer used for asynch writing to io */
+        size_t write_len; /* length of raw data in write buffer (0 - write until null char) */
         int write_state; /* before, data, after flush io write state */
         cat_state write_state_after; /* parser state to set after flush io write */
         bool implicit_write_flag; /* flag that implicit write was detected */
+        bool args_stream_flag; /* flag that write arguments are decoded while they are received */
+        bool args_quote_flag; /* flag that received arguments are inside quoted string */
+        bool args_escape_flag; /* flag that next received char is escaped inside quoted string */
+        size_t var_buf_pos; /* offset of current variable slot in variables scratch buffer */
+        bool io_blocked_flag; /* flag that output stream did not accept data in last fsm step */
 
         struct cat_unsolicited_fsm unsolicited_fsm;
 };
@@ -359,13 +424,18 @@ struct cat_object {
 /**
  * Function used to initialize at command parser.
  * Initialize starting values of object fields.
+ * Parser object must not be used when initialization fails.
  * 
  * @param self pointer to at command parser object to initialize
  * @param desc pointer to at command parser descriptor
  * @param io pointer to at command parser io low-level layer interface
  * @param mutex pointer to at command partes mutex interface
+ * @return CAT_STATUS_OK - parser object initialized
+ *         CAT_STATUS_ERROR - descriptor registers more commands or command groups than CAT_COMMAND_INDEX_SIZE,
+ *                            command name is longer than 255 chars, or variables scratch buffer is not 32-bit aligned
+ *                            or too small for variables of some command
  */
-void cat_init(struct cat_object *self, const struct cat_descriptor *desc, const struct cat_io_interface *io, const struct cat_mutex_interface *mutex);
+cat_status cat_init(struct cat_object *self, const struct cat_descriptor *desc, const struct cat_io_interface *io, const struct cat_mutex_interface *mutex);
 
 /**
  * Function must be called periodically to asynchronoulsy run at command parser.
@@ -376,6 +446,33 @@ void cat_init(struct cat_object *self, const struct cat_descriptor *desc, const
  */
 cat_status cat_service(struct cat_object *self);
 
+/**
+ * Function used to run at command parser in batch mode.
+ * It works like cat_service, but keeps stepping both internal state machines (with single mutex lock)
+ * until there is no more input to process, output stream is blocked, parser is held or steps budget is spent.
+ * Commands handlers will be call from this function context.
+ * 
+ * @param self pointer to at command parser object
+ * @param max_steps maximum number of state machine steps to perform (must be greater than 0)
+ * @return CAT_STATUS_OK - all buffered input was processed, parser waits for new input
+ *         CAT_STATUS_BUSY - parser still has work to do (steps budget spent, output blocked or hold state)
+ *         other values according to cat_status enum definitions
+ */
+cat_status cat_service_run(struct cat_object *self, size_t max_steps);
+
+/**
+ * Function return flag which indicating that parser cannot make progress by itself.
+ * It is usefull after cat_service_run returned CAT_STATUS_BUSY, to distinguish spent steps budget
+ * (call service again) from blocked output stream or hold state (wait for output space, cat_hold_exit or unsolicited event).
+ * 
+ * @param self pointer to at command parser object
+ * @return CAT_STATUS_BUSY - output stream is blocked or parser waits in hold state
+ *         CAT_STATUS_OK - parser is not stalled
+ *         CAT_STATUS_ERROR_MUTEX_LOCK - cannot lock mutex error
+ *         CAT_STATUS_ERROR_MUTEX_UNLOCK - cannot unlock mutex error
+ */
+cat_status cat_is_stalled(struct cat_object *self);
+
 /**
  * Function return flag which indicating internal busy state.
  * It is used to determine whether external application modules can use shared input / output interfaces functions.
@@ -454,6 +551,50 @@ cat_status cat_trigger_unsolicited_test(struct cat_object *self, struct cat_comm
  */
 cat_status cat_hold_exit(struct cat_object *self, cat_status status);
 
+/**
+ * Function used to start raw data phase of currently processed write command.
+ * It must be called only from write command handler (parser mutex is already held there),
+ * which then returns CAT_RETURN_STATE_DATA_PHASE.
+ * Parser sends "> " prompt and passes exactly len following input bytes to command data handler,
+ * without interpreting them, then sends OK or ERROR and returns to command mode.
+ * When the command line ended with <cr>, the prompt is sent only after the next input byte arrives:
+ * <lf> is consumed as part of line terminator, any other byte is the first payload byte.
+ * For hosts ending lines with bare <cr>, application calls cat_data_phase_prompt after a short timeout.
+ * Every byte received after the prompt is payload.
+ * 
+ * @param self pointer to at command parser object
+ * @param len number of payload bytes (must be greater than 0)
+ * @return CAT_STATUS_OK - data phase will start after write handler returns CAT_RETURN_STATE_DATA_PHASE
+ *         CAT_STATUS_ERROR - not called from write handler, command has no data handler or len is 0
+ */
+cat_status cat_data_phase_start(struct cat_object *self, size_t len);
+
+/**
+ * Function used to stop waiting for byte following <cr> which ended the data phase command line
+ * and send the prompt immediately (byte received after it is payload, even <lf>).
+ * It is intended to be called after a short timeout, for hosts terminating command lines with bare <cr>.
+ * 
+ * @param self pointer to at command parser object
+ * @return CAT_STATUS_OK - prompt will be sent
+ *         CAT_STATUS_ERROR - parser does not wait for byte following <cr>
+ *         CAT_STATUS_ERROR_MUTEX_LOCK - cannot lock mutex error
+ *         CAT_STATUS_ERROR_MUTEX_UNLOCK - cannot unlock mutex error
+ */
+cat_status cat_data_phase_prompt(struct cat_object *self);
+
+/**
+ * Function used to abort pending data phase (for example when host stopped sending payload).
+ * Payload bytes already received (up to announced length) are discarded without calling data handler,
+ * rest of payload is not waited for, then parser sends ERROR and returns to command mode.
+ * 
+ * @param self pointer to at command parser object
+ * @return CAT_STATUS_OK - data phase aborted
+ *         CAT_STATUS_ERROR - parser is not in data phase or data phase is already aborted
+ *         CAT_STATUS_ERROR_MUTEX_LOCK - cannot lock mutex error
+ *         CAT_STATUS_ERROR_MUTEX_UNLOCK - cannot unlock mutex error
+ */
+cat_status cat_data_phase_abort(struct cat_object *self);
+
 /**
  * Function used to searching registered command by its name.
  * 
@@ -472,6 +613,33 @@ struct cat_command const* cat_search_command_by_name(struct cat_object *self, co
  */
 struct cat_command_group const* cat_search_command_group_by_name(struct cat_object *self, const char *name);
 
+/**
+ * Function used to enable or disable registered command at runtime.
+ * Command stays disabled while its group is disabled.
+ * 
+ * @param self pointer to at command parser object
+ * @param cmd pointer to registered command
+ * @param disable true - disable command, false - enable command
+ * @return CAT_STATUS_OK - success
+ *         CAT_STATUS_ERROR - command is not registered
+ *         CAT_STATUS_ERROR_MUTEX_LOCK - cannot lock mutex error
+ *         CAT_STATUS_ERROR_MUTEX_UNLOCK - cannot unlock mutex error
+ */
+cat_status cat_set_command_disable(struct cat_object *self, struct cat_command const *cmd, bool disable);
+
+/**
+ * Function used to enable or disable all commands in registered command group at runtime.
+ * 
+ * @param self pointer to at command parser object
+ * @param cmd_group pointer to registered command group
+ * @param disable true - disable command group, false - enable command group
+ * @return CAT_STATUS_OK - success
+ *         CAT_STATUS_ERROR - command group is not registered
+ *         CAT_STATUS_ERROR_MUTEX_LOCK - cannot lock mutex error
+ *         CAT_STATUS_ERROR_MUTEX_UNLOCK - cannot unlock mutex error
+ */
+cat_status cat_set_command_group_disable(struct cat_object *self, struct cat_command_group const *cmd_group, bool disable);
+
 /**
  * Function used to searching attached variable to command its name.
  * 
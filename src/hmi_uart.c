@@ -7,6 +7,97 @@ LOG_MODULE_REGISTER(hmi_uart_module, LOG_LEVEL_INF);
 
 // 靜態函數聲明
 static void hmi_uart_callback_internal(const struct device *dev, struct uart_event *evt, void *user_data);
+static void hmi_uart_tx_start(struct hmi_uart_data *data);
+static uint8_t *hmi_uart_rx_buf_alloc(struct hmi_uart_data *data);
+static void hmi_uart_rx_buf_free(struct hmi_uart_data *data, uint8_t *buf);
+static void hmi_uart_rx_start(struct hmi_uart_data *data);
+static uint32_t hmi_uart_rx_watermark(struct hmi_uart_data *data, uint32_t percent);
+static uint32_t hmi_uart_rx_fill(struct hmi_uart_data *data);
+
+BUILD_ASSERT(HMI_UART_RX_LOW_WATERMARK < HMI_UART_RX_HIGH_WATERMARK,
+             "HMI_UART_RX_LOW_WATERMARK must be below HMI_UART_RX_HIGH_WATERMARK");
+
+// 從接收緩衝區池取出一個空閒的緩衝區，沒有空閒緩衝區時回傳 NULL
+static uint8_t *hmi_uart_rx_buf_alloc(struct hmi_uart_data *data)
+{
+    for (int i = 0; i < HMI_UART_RX_BUFF_NEM; i++) {
+        if (!atomic_test_and_set_bit(&data->rx_buf_used, i)) {
+            return data->rx_buf[i];
+        }
+    }
+    return NULL;
+}
+
+// 將驅動釋放的緩衝區歸還到接收緩衝區池
+static void hmi_uart_rx_buf_free(struct hmi_uart_data *data, uint8_t *buf)
+{
+    size_t offset = buf - &data->rx_buf[0][0];
+
+    if ((buf < &data->rx_buf[0][0]) || (offset >= sizeof(data->rx_buf))) {
+        LOG_WRN("%s: 釋放了不屬於緩衝區池的接收緩衝區", data->dev->name);
+        return;
+    }
+    atomic_clear_bit(&data->rx_buf_used, offset / HMI_UART_RX_MSG_SIZE);
+}
+
+// 若發送閒置，從發送環形緩衝區取出一段連續資料並啟動 DMA 傳輸
+static void hmi_uart_tx_start(struct hmi_uart_data *data)
+{
+    k_spinlock_key_t key = k_spin_lock(&data->tx_lock);
+    uint8_t *buf;
+    uint32_t len;
+    int ret;
+
+    if (data->tx_len != 0) {
+        k_spin_unlock(&data->tx_lock, key);
+        return;
+    }
+
+    // 先登記傳輸長度佔用發送流程，uart_tx() 不在鎖內呼叫，避免驅動同步回調時重入
+    len = ring_buf_get_claim(data->tx_rbuf, &buf, ring_buf_capacity_get(data->tx_rbuf));
+    data->tx_len = len;
+    k_spin_unlock(&data->tx_lock, key);
+
+    if (len == 0) {
+        return;
+    }
+
+    ret = uart_tx(data->dev, buf, len, SYS_FOREVER_US);
+    if (ret) {
+        // 釋放本次取得的區段，資料留在緩衝區等待下次啟動
+        key = k_spin_lock(&data->tx_lock);
+        ring_buf_get_finish(data->tx_rbuf, 0);
+        data->tx_len = 0;
+        k_spin_unlock(&data->tx_lock, key);
+        LOG_ERR("UART %s 啟動 DMA 傳輸失敗: %d", data->dev->name, ret);
+    }
+}
+
+// 從緩衝區池取出緩衝區並啟用接收
+static void hmi_uart_rx_start(struct hmi_uart_data *data)
+{
+    uint8_t *buf = hmi_uart_rx_buf_alloc(data);
+    int ret = -ENOMEM;
+
+    if (buf != NULL) {
+        ret = uart_rx_enable(data->dev, buf, HMI_UART_RX_MSG_SIZE, HMI_UART_RX_TIMEOUT_US);
+    }
+    if (ret) {
+        LOG_ERR("啟用 UART %s 接收失敗: %d", data->dev->name, ret);
+    }
+}
+
+// 將水位百分比換算成接收環形緩衝區的位元組數
+static uint32_t hmi_uart_rx_watermark(struct hmi_uart_data *data, uint32_t percent)
+{
+    return (ring_buf_capacity_get(data->rx_rbuf) * percent) / 100U;
+}
+
+// 接收環形緩衝區已佔用的位元組數，包含消耗端已 claim 但尚未 finish 的部分
+static uint32_t hmi_uart_rx_fill(struct hmi_uart_data *data)
+{
+    return ring_buf_capacity_get(data->rx_rbuf) - ring_buf_space_get(data->rx_rbuf);
+}
 
 // 內部 UART 回調函數
 // 這個回調函數將處理所有由 Zephyr UART 驅動發出的事件，並將其分發到正確的 hmi_uart_data 實例。
@@ -27,6 +118,25 @@ static void hmi_uart_callback_internal(const struct device *dev, struct uart_eve
                 , evt->data.rx.len) == 0) {
                 LOG_WRN("%s: 1 Failed to put message in RX queue (full?).", data->dev->name);
             }
+            if (data->rx_sem != NULL) {
+                k_sem_give(data->rx_sem);
+            }
+
+            // 超過高水位時停止接收 (啟用硬體流量控制時會同時拉高 RTS)，等待消耗端恢復
+            k_spinlock_key_t key = k_spin_lock(&data->rx_lock);
+            bool pause = !data->rx_paused
+                && (hmi_uart_rx_fill(data) >= hmi_uart_rx_watermark(data, HMI_UART_RX_HIGH_WATERMARK));
+
+            if (pause) {
+                data->rx_paused = true;
+                data->rx_stopped = false;
+            }
+            k_spin_unlock(&data->rx_lock, key);
+
+            if (pause) {
+                LOG_DBG("%s: RX paused", dev->name);
+                uart_rx_disable(dev);
+            }
             break;
         }
         case UART_RX_STOPPED: {
@@ -35,45 +145,62 @@ static void hmi_uart_callback_internal(const struct device *dev, struct uart_eve
         }
         case UART_RX_BUF_REQUEST:
         {
-            if(data->rx_buf_idx == 0)
-            {
-                data->rx_buf_idx = 1;
-            }else
-            {
-                data->rx_buf_idx = 0;
+            // 提前提供下一個緩衝區，讓 DMA 在目前緩衝區填滿後無縫切換
+            uint8_t *buf = hmi_uart_rx_buf_alloc(data);
+
+            if (buf == NULL) {
+                LOG_WRN("%s: 接收緩衝區池已用完", dev->name);
+                break;
             }
-            uart_rx_buf_rsp(dev, data->rx_buf[data->rx_buf_idx], HMI_UART_RX_MSG_SIZE);
+            uart_rx_buf_rsp(dev, buf, HMI_UART_RX_MSG_SIZE);
             break;
         }
         case UART_RX_BUF_RELEASED:
-            // 緩衝區釋放事件，用於資源管理
+            // 驅動不再使用此緩衝區，歸還到緩衝區池
+            hmi_uart_rx_buf_free(data, evt->data.rx_buf.buf);
             break;
         case UART_RX_DISABLED:
         {
-            int ret = 0;
-            if(data->rx_buf_idx == 0)
-            {
-                data->rx_buf_idx = 1;
-            }else
-            {
-                data->rx_buf_idx = 0;
+            // 接收因錯誤、緩衝區用完或背壓暫停而停止，所有緩衝區已釋放
+            k_spinlock_key_t key = k_spin_lock(&data->rx_lock);
+            bool restart = true;
+
+            if (data->rx_paused) {
+                // 暫停期間若消耗端已降到低水位以下，立即恢復，否則等待 hmi_uart_rx_resume()
+                if (hmi_uart_rx_fill(data) <= hmi_uart_rx_watermark(data, HMI_UART_RX_LOW_WATERMARK)) {
+                    data->rx_paused = false;
+                } else {
+                    data->rx_stopped = true;
+                    restart = false;
+                }
             }
-            ret = uart_rx_enable(dev, data->rx_buf[data->rx_buf_idx], HMI_UART_RX_MSG_SIZE, 100);
-            if (ret) {
-                LOG_ERR("啟用 UART %s 接收失敗: %d", dev->name, ret);
+            k_spin_unlock(&data->rx_lock, key);
+
+            if (restart) {
+                hmi_uart_rx_start(data);
             }
             //LOG_INF("%s: UART_RX_DISABLED", dev->name);
             break;
         }
         case UART_TX_DONE:
-            // 傳輸完成事件。如果需要，可以在此處理 TX 完成的邏輯
-            // 例如，釋放 TX 緩衝區或通知等待的線程
-            LOG_DBG("%s: UART_TX_DONE", dev->name);
-            break;
-
         case UART_TX_ABORTED:
-            //LOG_WRN("%s: UART_EVT_TX_ABORTED", dev->name);
+        {
+            // 釋放已送出的區段，並接續發送緩衝區中剩餘的資料
+            k_spinlock_key_t key = k_spin_lock(&data->tx_lock);
+
+            ring_buf_get_finish(data->tx_rbuf, evt->data.tx.len);
+            data->tx_len = 0;
+            k_spin_unlock(&data->tx_lock, key);
+
+            LOG_DBG("%s: UART_TX_DONE %d", dev->name, evt->data.tx.len);
+            hmi_uart_tx_start(data);
+
+            // 通知因發送緩衝區已滿而停下的寫入端
+            if (data->tx_sem != NULL) {
+                k_sem_give(data->tx_sem);
+            }
             break;
+        }
 
         default:
             // 處理其他未知的 UART 事件
@@ -83,7 +210,7 @@ static void hmi_uart_callback_internal(const struct device *dev, struct uart_eve
 
 int hmi_uart_init_instance(struct hmi_uart_data *instance_data, uint32_t baud_rate)
 {
-    const struct device *uart_dev = instance_data->dev;
+    const struct device *uart_dev;
     struct uart_config uart_cfg = {
         .baudrate = baud_rate,
         .parity = UART_CFG_PARITY_NONE,
@@ -93,19 +220,33 @@ int hmi_uart_init_instance(struct hmi_uart_data *instance_data, uint32_t baud_ra
     };
     int ret;
 
+    if (instance_data == NULL) {
+        LOG_ERR("hmi_uart_init_instance 接收到 NULL 指針！");
+        return -EINVAL;
+    }
+
+    uart_dev = instance_data->dev;
     if (!device_is_ready(uart_dev)) {
         LOG_ERR("UART 設備 %s 未準備就緒！", uart_dev->name);
         return -ENODEV;
     }
 
-    if (instance_data == NULL) {
-        LOG_ERR("hmi_uart_init_instance 接收到 NULL 指針！");
-        return -EINVAL;
+    if (instance_data->hw_flow_ctrl) {
+        uart_cfg.flow_ctrl = UART_CFG_FLOW_CTRL_RTS_CTS;
     }
 
     // 將外部提供的數據結構和消息佇列指針賦值給實例
     instance_data->dev = uart_dev;
     instance_data->rx_buf_pos = 0;
+    atomic_clear(&instance_data->rx_buf_used);
+    instance_data->rx_paused = false;
+    instance_data->rx_stopped = false;
+    instance_data->tx_len = 0;
+
+    if (instance_data->tx_rbuf == NULL) {
+        LOG_ERR("UART %s 未綁定發送緩衝區！", uart_dev->name);
+        return -EINVAL;
+    }
 
     ret = uart_configure(uart_dev, &uart_cfg);
     if (ret) {
@@ -120,27 +261,62 @@ int hmi_uart_init_instance(struct hmi_uart_data *instance_data, uint32_t baud_ra
         return ret;
     }
 
-    // 啟用接收，使用實例的接收緩衝區
-    ret = uart_rx_enable(uart_dev, instance_data->rx_buf[0], HMI_UART_RX_MSG_SIZE, 100);
+    // 啟用接收，使用緩衝區池中的第一個緩衝區
+    ret = uart_rx_enable(uart_dev, hmi_uart_rx_buf_alloc(instance_data), HMI_UART_RX_MSG_SIZE, HMI_UART_RX_TIMEOUT_US);
     if (ret) {
         LOG_ERR("啟用 UART %s 接收失敗: %d", uart_dev->name, ret);
         return ret;
     }
 
-    LOG_INF("HMI UART 模組 %s 初始化成功，波特率: %d", uart_dev->name, baud_rate);
+    LOG_INF("HMI UART 模組 %s 初始化成功，波特率: %d，硬體流量控制: %s", uart_dev->name, baud_rate,
+        instance_data->hw_flow_ctrl ? "RTS/CTS" : "無");
     return 0;
 }
 
-int hmi_uart_send(const struct device *uart_dev, const uint8_t *data, size_t len)
+void hmi_uart_rx_resume(struct hmi_uart_data *instance_data)
 {
-    if (!device_is_ready(uart_dev)) {
-        LOG_ERR("UART 設備 %s 未準備就緒，無法傳送！", uart_dev->name);
-        return -ENODEV;
+    k_spinlock_key_t key;
+    bool resume;
+
+    if (instance_data == NULL) {
+        return;
     }
 
-    int ret = uart_tx(uart_dev, data, len, SYS_FOREVER_US);
-    if (ret < 0) {
-        LOG_ERR("UART %s 寫入 FIFO 失敗: %d", uart_dev->name, ret);
+    // 只有在驅動已停止接收後才重新啟用；停止事件尚未到達時由 UART_RX_DISABLED 處理
+    key = k_spin_lock(&instance_data->rx_lock);
+    resume = instance_data->rx_paused && instance_data->rx_stopped
+        && (hmi_uart_rx_fill(instance_data) <= hmi_uart_rx_watermark(instance_data, HMI_UART_RX_LOW_WATERMARK));
+    if (resume) {
+        instance_data->rx_paused = false;
+        instance_data->rx_stopped = false;
     }
-    return ret; // 返回
+    k_spin_unlock(&instance_data->rx_lock, key);
+
+    if (resume) {
+        LOG_DBG("%s: RX resumed", instance_data->dev->name);
+        hmi_uart_rx_start(instance_data);
+    }
+}
+
+int hmi_uart_send(struct hmi_uart_data *instance_data, const uint8_t *data, size_t len)
+{
+    k_spinlock_key_t key;
+    uint32_t written;
+
+    if ((instance_data == NULL) || (instance_data->tx_rbuf == NULL)) {
+        return -EINVAL;
+    }
+
+    if (!device_is_ready(instance_data->dev)) {
+        LOG_ERR("UART 設備 %s 未準備就緒，無法傳送！", instance_data->dev->name);
+        return -ENODEV;
+    }
+
+    // 與 UART_TX_DONE 中的取出流程互斥，確保環形緩衝區狀態一致
+    key = k_spin_lock(&instance_data->tx_lock);
+    written = ring_buf_put(instance_data->tx_rbuf, data, len);
+    k_spin_unlock(&instance_data->tx_lock, key);
+
+    hmi_uart_tx_start(instance_data);
+    return written; // 返回實際放入的位元組數
 }
\ No newline at end of file
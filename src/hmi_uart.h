@@ -4,20 +4,37 @@
 #include <zephyr/kernel.h>
 #include <zephyr/drivers/uart.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/atomic.h>
 
-// UART 接收緩衝區大小
-#define HMI_UART_RX_MSG_SIZE (64) //
-#define HMI_UART_RX_BUFF_NEM (2)
+// UART 接收緩衝區大小與數量 (由 Kconfig 設定)
+#define HMI_UART_RX_MSG_SIZE (CONFIG_HMI_UART_RX_BUF_SIZE)
+#define HMI_UART_RX_BUFF_NEM (CONFIG_HMI_UART_RX_BUF_COUNT)
+// 接收閒置逾時 (微秒)
+#define HMI_UART_RX_TIMEOUT_US (CONFIG_HMI_UART_RX_TIMEOUT_US)
+// 接收環形緩衝區暫停/恢復接收的水位 (百分比)
+#define HMI_UART_RX_HIGH_WATERMARK (CONFIG_HMI_UART_RX_HIGH_WATERMARK)
+#define HMI_UART_RX_LOW_WATERMARK (CONFIG_HMI_UART_RX_LOW_WATERMARK)
 /**
  * @brief HMI UART 實例的數據結構。
  * 包含每個 UART 實例的運行時數據。
  */
 struct hmi_uart_data {
     const struct device *dev;         // UART 設備指針
-    uint8_t rx_buf[HMI_UART_RX_BUFF_NEM][HMI_UART_RX_MSG_SIZE]; // 接收緩衝區
-    uint8_t rx_buf_idx;
+    uint8_t rx_buf[HMI_UART_RX_BUFF_NEM][HMI_UART_RX_MSG_SIZE]; // 接收緩衝區池
+    atomic_t rx_buf_used;             // 已交給驅動使用的接收緩衝區位元遮罩
     size_t rx_buf_pos;                // 接收緩衝區當前位置
     struct ring_buf *rx_rbuf;           // 綁定到此實例的接收消息隊列指針
+    struct k_sem *rx_sem;               // 收到資料時發出通知的信號量 (可選，可為 NULL)
+    bool hw_flow_ctrl;                  // 是否啟用 RTS/CTS 硬體流量控制
+    bool rx_paused;                     // 接收因環形緩衝區超過高水位而暫停
+    bool rx_stopped;                    // 暫停期間驅動已回報 UART_RX_DISABLED
+    struct k_spinlock rx_lock;          // 保護接收暫停/恢復狀態
+    struct ring_buf *tx_rbuf;           // 綁定到此實例的發送環形緩衝區
+    struct k_sem *tx_sem;               // 發送緩衝區騰出空間時發出通知的信號量 (可選，可為 NULL)
+    size_t tx_len;                      // 目前 DMA 傳輸中的資料長度，0 表示發送閒置
+    struct k_spinlock tx_lock;          // 保護發送環形緩衝區與 DMA 啟動流程
 };
 
 /**
@@ -32,14 +49,27 @@ struct hmi_uart_data {
 int hmi_uart_init_instance(struct hmi_uart_data *instance_data, uint32_t baud_rate);
 
 /**
- * @brief 向指定的 HMI UART 設備發送數據 (非阻塞)。
+ * @brief 通知 HMI UART 實例接收環形緩衝區已被消耗。
  *
- * @param uart_dev 指向要發送數據的 UART 設備的指針。
+ * 接收因背壓暫停時，若環形緩衝區已降到低水位以下，會重新啟用接收。
+ * 消耗 rx_rbuf 資料的一方應在釋放資料後呼叫此函式。
+ *
+ * @param instance_data 指向 HMI UART 實例數據結構的指針。
+ */
+void hmi_uart_rx_resume(struct hmi_uart_data *instance_data);
+
+/**
+ * @brief 向指定的 HMI UART 實例發送數據 (非阻塞)。
+ *
+ * 數據會被複製到實例的發送環形緩衝區，呼叫後即可重複使用 data 緩衝區。
+ * DMA 直接從環形緩衝區的連續區段發送，並在 UART_TX_DONE 時接續下一段。
+ *
+ * @param instance_data 指向 HMI UART 實例數據結構的指針。
  * @param data 指向要發送數據的緩衝區的指針。
  * @param len 要發送的數據長度。
  *
- * @return 回傳傳送成功或失敗，0為成功，負數 errno 表示失敗。
+ * @return 回傳實際放入發送緩衝區的位元組數 (緩衝區滿時可能小於 len)，負數 errno 表示失敗。
  */
-int hmi_uart_send(const struct device *uart_dev, const uint8_t *data, size_t len);
+int hmi_uart_send(struct hmi_uart_data *instance_data, const uint8_t *data, size_t len);
 
 #endif // HMI_UART_H__
\ No newline at end of file
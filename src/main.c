@@ -6,14 +6,18 @@
 
 #include <zephyr/kernel.h>
 #include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
 #include <zephyr/bluetooth/services/nus.h>
+#include <zephyr/logging/log.h>
 #include <zephyr/sys/ring_buffer.h>
 #include "value_reporter.h"
+#include "at_command.h"
+
+LOG_MODULE_REGISTER(main, LOG_LEVEL_INF);
 
 #define DEVICE_NAME		CONFIG_BT_DEVICE_NAME
 #define DEVICE_NAME_LEN		(sizeof(DEVICE_NAME) - 1)
 
-extern struct ring_buf uart_at_ringbuf;
 static const struct bt_data ad[] = {
 	BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
 	BT_DATA(BT_DATA_NAME_COMPLETE, DEVICE_NAME, DEVICE_NAME_LEN),
@@ -23,6 +27,25 @@ static const struct bt_data sd[] = {
 	BT_DATA_BYTES(BT_DATA_UUID128_ALL, BT_UUID_NUS_SRV_VAL),
 };
 
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+	if (err) {
+		return;
+	}
+	at_command_nus_connected(conn);
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+	printk("%s() - reason: 0x%02x\n", __func__, reason);
+	at_command_nus_disconnected(conn);
+}
+
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+	.connected = connected,
+	.disconnected = disconnected,
+};
+
 static void notif_enabled(bool enabled, void *ctx)
 {
 	ARG_UNUSED(ctx);
@@ -32,18 +55,14 @@ static void notif_enabled(bool enabled, void *ctx)
 
 static void received(struct bt_conn *conn, const void *data, uint16_t len, void *ctx)
 {
-	char message[CONFIG_BT_L2CAP_TX_MTU + 1] = "";
+	int err;
 
-	ARG_UNUSED(conn);
 	ARG_UNUSED(ctx);
 
-	memcpy(message, data, MIN(sizeof(message) - 1, len));
-	if (ring_buf_put(&uart_at_ringbuf
-                , data
-                , len) == 0) {
-                printk("BT: Failed to put message in RX queue (full?).");
-            }
-	printk("%s() - Len: %d, Message: %s\n", __func__, len, message);
+	err = at_command_nus_received(conn, data, len);
+	if (err) {
+		LOG_WRN("Dropped %u bytes from NUS: %d", len, err);
+	}
 }
 
 struct bt_nus_cb nus_listener = {
@@ -0,0 +1,361 @@
+#include <stdbool.h>
+#include <string.h>
+#include "numfmt.h"
+
+// 00 ~ 99 的兩位數字表，十進位輸出每次處理兩位，除法次數減半
+static const char numfmt_dec_pairs[200] = {
+    '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+    '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+    '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+    '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+    '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+    '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+    '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+    '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+    '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+    '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9',
+};
+
+// 十六進位字元對應的數值加 1，0 表示不是十六進位字元
+static const uint8_t numfmt_hex_values[256] = {
+    ['0'] = 1,  ['1'] = 2,  ['2'] = 3,  ['3'] = 4,  ['4'] = 5,
+    ['5'] = 6,  ['6'] = 7,  ['7'] = 8,  ['8'] = 9,  ['9'] = 10,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+};
+
+#define NUMFMT_SWAR_ONES (0x0101010101010101ULL)
+
+static size_t numfmt_dec_len(uint32_t val)
+{
+    if(val < 10U) return 1;
+    if(val < 100U) return 2;
+    if(val < 1000U) return 3;
+    if(val < 10000U) return 4;
+    if(val < 100000U) return 5;
+    if(val < 1000000U) return 6;
+    if(val < 10000000U) return 7;
+    if(val < 100000000U) return 8;
+    if(val < 1000000000U) return 9;
+    return 10;
+}
+
+// 從 end 往前寫入 val 的十進位數字
+static void numfmt_write_dec(char *end, uint32_t val)
+{
+    while(val >= 100U)
+    {
+        uint32_t q = val / 100U;
+        const char *pair = &numfmt_dec_pairs[(val - q * 100U) * 2U];
+
+        *--end = pair[1];
+        *--end = pair[0];
+        val = q;
+    }
+
+    if(val >= 10U)
+    {
+        *--end = numfmt_dec_pairs[val * 2U + 1U];
+        *--end = numfmt_dec_pairs[val * 2U];
+    }else
+    {
+        *--end = (char)('0' + val);
+    }
+}
+
+size_t numfmt_u32_to_dec(char *buf, uint32_t val)
+{
+    size_t len = numfmt_dec_len(val);
+
+    numfmt_write_dec(buf + len, val);
+    return len;
+}
+
+size_t numfmt_u32_to_dec_pad(char *buf, uint32_t val, size_t width)
+{
+    size_t len = numfmt_dec_len(val);
+
+    if(width > len)
+    {
+        memset(buf, '0', width - len);
+        len = width;
+    }
+    numfmt_write_dec(buf + len, val);
+    return len;
+}
+
+size_t numfmt_i32_to_dec(char *buf, int32_t val)
+{
+    if(val < 0)
+    {
+        buf[0] = '-';
+        // 以無號數取絕對值，INT32_MIN 也不會溢位
+        return 1 + numfmt_u32_to_dec(&buf[1], 0U - (uint32_t)val);
+    }
+    return numfmt_u32_to_dec(buf, (uint32_t)val);
+}
+
+// 把 x 的 8 個 nibble 攤開到 8 個 byte (byte k 為第 k 個 nibble)，再一次轉成大寫 ASCII
+static uint64_t numfmt_hex8_ascii(uint32_t val)
+{
+    uint64_t x = val;
+    uint64_t alpha;
+
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    // nibble >= 10 時 +6 會進位到高 4 bits，這些 byte 需要再補上 'A' - '9' - 1
+    alpha = ((x + 0x06 * NUMFMT_SWAR_ONES) >> 4) & NUMFMT_SWAR_ONES;
+    return x + '0' * NUMFMT_SWAR_ONES + alpha * ('A' - '9' - 1);
+}
+
+void numfmt_u32_to_hex(char *buf, uint32_t val, size_t digits)
+{
+    uint64_t x = numfmt_hex8_ascii(val);
+
+    for(size_t i = 0; i < digits; i++)
+    {
+        buf[i] = (char)(x >> ((digits - 1U - i) * 8U));
+    }
+}
+
+// 小端序下記憶體順序即為數值的位元組順序，memcpy 會編譯成一般的 (非對齊) 存取
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define NUMFMT_LITTLE_ENDIAN 1
+#else
+#define NUMFMT_LITTLE_ENDIAN 0
+#endif
+
+// 依記憶體順序讀取 8 個字元，第一個字元在最低位元組
+static uint64_t numfmt_load8(const char *str)
+{
+    uint64_t chunk = 0;
+
+#if NUMFMT_LITTLE_ENDIAN
+    memcpy(&chunk, str, sizeof(chunk));
+#else
+    for(size_t i = 0; i < 8; i++)
+    {
+        chunk |= (uint64_t)(uint8_t)str[i] << (i * 8U);
+    }
+#endif
+    return chunk;
+}
+
+// 依記憶體順序寫入 8 個字元，最低位元組為第一個字元
+static void numfmt_store8(char *str, uint64_t chunk)
+{
+#if NUMFMT_LITTLE_ENDIAN
+    memcpy(str, &chunk, sizeof(chunk));
+#else
+    for(size_t i = 0; i < 8; i++)
+    {
+        str[i] = (char)(chunk >> (i * 8U));
+    }
+#endif
+}
+
+// 依記憶體順序讀取 4 個位元組，第一個位元組在最低位
+static uint32_t numfmt_load4(const uint8_t *data)
+{
+    uint32_t word = 0;
+
+#if NUMFMT_LITTLE_ENDIAN
+    memcpy(&word, data, sizeof(word));
+#else
+    for(size_t i = 0; i < 4; i++)
+    {
+        word |= (uint32_t)data[i] << (i * 8U);
+    }
+#endif
+    return word;
+}
+
+// 依記憶體順序寫入 4 個位元組，最低位元組在前
+static void numfmt_store4(uint8_t *data, uint32_t word)
+{
+#if NUMFMT_LITTLE_ENDIAN
+    memcpy(data, &word, sizeof(word));
+#else
+    for(size_t i = 0; i < 4; i++)
+    {
+        data[i] = (uint8_t)(word >> (i * 8U));
+    }
+#endif
+}
+
+static bool numfmt_is_dec8(uint64_t chunk)
+{
+    return ((chunk & 0xF0F0F0F0F0F0F0F0ULL)
+        | (((chunk + 0x06 * NUMFMT_SWAR_ONES) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x33 * NUMFMT_SWAR_ONES;
+}
+
+// 8 個十進位字元一次轉成數值：相鄰的數字兩兩合併，3 步完成
+static uint32_t numfmt_dec8_value(uint64_t chunk)
+{
+    chunk -= '0' * NUMFMT_SWAR_ONES;
+    chunk = (chunk * 10U + (chunk >> 8)) & 0x00FF00FF00FF00FFULL;
+    chunk = (chunk * 100U + (chunk >> 16)) & 0x0000FFFF0000FFFFULL;
+    chunk = (chunk * 10000U + (chunk >> 32)) & 0x00000000FFFFFFFFULL;
+    return (uint32_t)chunk;
+}
+
+size_t numfmt_dec_to_u64(const char *str, size_t len, uint64_t *val)
+{
+    uint64_t acc = 0;
+    bool overflow = false;
+    size_t n = 0;
+
+    while(len - n >= 8U)
+    {
+        uint64_t chunk = numfmt_load8(&str[n]);
+        uint32_t part;
+
+        if(!numfmt_is_dec8(chunk))
+        {
+            break;
+        }
+        part = numfmt_dec8_value(chunk);
+        if(acc > (UINT64_MAX - part) / 100000000U)
+        {
+            overflow = true;
+        }
+        acc = acc * 100000000U + part;
+        n += 8U;
+    }
+
+    while(n < len && str[n] >= '0' && str[n] <= '9')
+    {
+        uint32_t digit = (uint32_t)(str[n] - '0');
+
+        if(acc > (UINT64_MAX - digit) / 10U)
+        {
+            overflow = true;
+        }
+        acc = acc * 10U + digit;
+        n++;
+    }
+
+    if(n != 0)
+    {
+        *val = overflow ? UINT64_MAX : acc;
+    }
+    return n;
+}
+
+size_t numfmt_hex_to_u64(const char *str, size_t len, uint64_t *val)
+{
+    uint64_t acc = 0;
+    bool overflow = false;
+    size_t n = 0;
+
+    while(n < len)
+    {
+        uint8_t digit = numfmt_hex_values[(uint8_t)str[n]];
+
+        if(digit == 0)
+        {
+            break;
+        }
+        if((acc >> 60) != 0)
+        {
+            overflow = true;
+        }
+        acc = (acc << 4) | (uint8_t)(digit - 1U);
+        n++;
+    }
+
+    if(n != 0)
+    {
+        *val = overflow ? UINT64_MAX : acc;
+    }
+    return n;
+}
+
+void numfmt_bytes_to_hex(char *buf, const uint8_t *data, size_t size)
+{
+    size_t i = 0;
+
+    // 每次 4 個位元組：先交換每個位元組的高低 nibble，攤開後第一個字元就落在最低位元組
+    for(; size - i >= 4U; i += 4U)
+    {
+        uint32_t word = numfmt_load4(&data[i]);
+
+        word = ((word >> 4) & 0x0F0F0F0FU) | ((word & 0x0F0F0F0FU) << 4);
+        numfmt_store8(&buf[i * 2U], numfmt_hex8_ascii(word));
+    }
+
+    for(; i < size; i++)
+    {
+        numfmt_u32_to_hex(&buf[i * 2U], data[i], 2);
+    }
+}
+
+// 每個位元組 (皆小於 0x80) 是否落在 [lo, hi]，是則該位元組的最高位元為 1
+#define NUMFMT_SWAR_IN_RANGE(x, lo, hi) \
+    (((x) + (0x80 - (lo)) * NUMFMT_SWAR_ONES) & ~((x) + (0x7F - (hi)) * NUMFMT_SWAR_ONES) & 0x80 * NUMFMT_SWAR_ONES)
+
+// 8 個十六進位字元一次驗證並轉成 4 個位元組 (第一個位元組在最低位)，含非十六進位字元時回傳 false
+static bool numfmt_hex8_bytes(uint64_t chunk, uint32_t *bytes)
+{
+    uint64_t digit;
+    uint64_t alpha;
+
+    if((chunk & 0x80 * NUMFMT_SWAR_ONES) != 0)
+    {
+        return false;
+    }
+    digit = NUMFMT_SWAR_IN_RANGE(chunk, '0', '9');
+    // 大小寫只差 0x20，統一轉成小寫後再比較
+    alpha = NUMFMT_SWAR_IN_RANGE(chunk | 0x20 * NUMFMT_SWAR_ONES, 'a', 'f');
+    if((digit | alpha) != 0x80 * NUMFMT_SWAR_ONES)
+    {
+        return false;
+    }
+
+    // 'A' ~ 'F' 與 'a' ~ 'f' 的低 4 bits 為 1 ~ 6，再加 9 即為數值
+    chunk = (chunk & 0x0F * NUMFMT_SWAR_ONES) + (alpha >> 7) * 9U;
+    // 相鄰兩個 nibble 合成一個位元組，再把位於偶數位置的 4 個位元組收攏
+    chunk = ((chunk << 4) | (chunk >> 8)) & 0x00FF00FF00FF00FFULL;
+    chunk = (chunk | (chunk >> 8)) & 0x0000FFFF0000FFFFULL;
+    *bytes = (uint32_t)(chunk | (chunk >> 16));
+    return true;
+}
+
+size_t numfmt_hex_to_bytes(uint8_t *data, const char *str, size_t len)
+{
+    size_t n = 0;
+    uint8_t byte = 0;
+
+    while(len - n >= 8U)
+    {
+        uint32_t bytes;
+
+        if(!numfmt_hex8_bytes(numfmt_load8(&str[n]), &bytes))
+        {
+            break;
+        }
+        if(data != NULL)
+        {
+            numfmt_store4(&data[n / 2U], bytes);
+        }
+        n += 8U;
+    }
+
+    while(n < len)
+    {
+        uint8_t digit = numfmt_hex_values[(uint8_t)str[n]];
+
+        if(digit == 0)
+        {
+            break;
+        }
+        byte = (uint8_t)((byte << 4) | (uint8_t)(digit - 1U));
+        if((n & 1U) != 0 && data != NULL)
+        {
+            data[n / 2U] = byte;
+        }
+        n++;
+    }
+    return n;
+}
@@ -0,0 +1,80 @@
+#ifndef NUMFMT_H__
+#define NUMFMT_H__
+#include <stdint.h>
+#include <stddef.h>
+
+// 各格式最長的輸出字元數 (不含 '\0')
+#define NUMFMT_U32_DEC_MAX_LEN (10U)
+#define NUMFMT_I32_DEC_MAX_LEN (11U)
+#define NUMFMT_U32_HEX_MAX_LEN (8U)
+
+/**
+ * @brief 將無號整數轉為十進位字串 (等同 "%u")。
+ *
+ * 輸出不含 '\0'，buf 至少需要 NUMFMT_U32_DEC_MAX_LEN bytes。
+ *
+ * @return 輸出的字元數
+ */
+size_t numfmt_u32_to_dec(char *buf, uint32_t val);
+
+/**
+ * @brief 將無號整數轉為至少 width 位、前面補 0 的十進位字串 (等同 "%0<width>u")。
+ *
+ * 輸出不含 '\0'，buf 至少需要 MAX(width, NUMFMT_U32_DEC_MAX_LEN) bytes。
+ *
+ * @return 輸出的字元數
+ */
+size_t numfmt_u32_to_dec_pad(char *buf, uint32_t val, size_t width);
+
+/**
+ * @brief 將有號整數轉為十進位字串 (等同 "%d")。
+ *
+ * 輸出不含 '\0'，buf 至少需要 NUMFMT_I32_DEC_MAX_LEN bytes。
+ *
+ * @return 輸出的字元數
+ */
+size_t numfmt_i32_to_dec(char *buf, int32_t val);
+
+/**
+ * @brief 將無號整數的低 digits 個 nibble 轉為大寫十六進位字串 (等同 "%0<digits>X")。
+ *
+ * 輸出不含 '\0'，digits 為 1 ~ NUMFMT_U32_HEX_MAX_LEN。
+ */
+void numfmt_u32_to_hex(char *buf, uint32_t val, size_t digits);
+
+/**
+ * @brief 從 str 開頭讀取連續的十進位數字。
+ *
+ * 最多讀取 len 個字元，遇到第一個非數字字元即停止。超出 uint64_t 範圍時 val 為 UINT64_MAX。
+ *
+ * @return 讀取的數字個數，0 表示開頭不是數字 (此時 val 不變)
+ */
+size_t numfmt_dec_to_u64(const char *str, size_t len, uint64_t *val);
+
+/**
+ * @brief 從 str 開頭讀取連續的十六進位數字 (大小寫皆可，不含 "0x" 前綴)。
+ *
+ * 最多讀取 len 個字元，遇到第一個非十六進位字元即停止。超出 uint64_t 範圍時 val 為 UINT64_MAX。
+ *
+ * @return 讀取的數字個數，0 表示開頭不是十六進位數字 (此時 val 不變)
+ */
+size_t numfmt_hex_to_u64(const char *str, size_t len, uint64_t *val);
+
+/**
+ * @brief 將 size 個位元組轉為大寫十六進位字串，每個位元組兩個字元。
+ *
+ * 輸出不含 '\0'，buf 至少需要 size * 2 bytes。
+ */
+void numfmt_bytes_to_hex(char *buf, const uint8_t *data, size_t size);
+
+/**
+ * @brief 從 str 開頭讀取連續的十六進位數字 (大小寫皆可)，每兩個數字寫入一個位元組。
+ *
+ * 最多讀取 len 個字元，遇到第一個非十六進位字元即停止。data 至少需要 len / 2 bytes，
+ * 為 NULL 時只檢查不寫入。讀取的數字個數為奇數時，最後一個數字不寫入。
+ *
+ * @return 讀取的數字個數
+ */
+size_t numfmt_hex_to_bytes(uint8_t *data, const char *str, size_t len);
+
+#endif // NUMFMT_H__
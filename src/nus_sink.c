@@ -0,0 +1,120 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/bluetooth/services/nus.h>
+#include "nus_sink.h"
+
+LOG_MODULE_REGISTER(nus_sink, LOG_LEVEL_INF);
+
+static size_t nus_sink_chunk_size(struct nus_sink *sink);
+static int nus_sink_send_locked(struct nus_sink *sink);
+
+// 依目前連線協商的 ATT MTU 計算單一 notification 可攜帶的資料長度
+static size_t nus_sink_chunk_size(struct nus_sink *sink)
+{
+    uint16_t mtu = bt_gatt_get_mtu(sink->conn);
+
+    if (mtu <= 3) {
+        return 1;
+    }
+    return MIN((size_t)(mtu - 3), sizeof(sink->buf));
+}
+
+// 發送緩衝區的資料；藍牙發送緩衝區暫時用完時保留資料並回傳 -EAGAIN
+static int nus_sink_send_locked(struct nus_sink *sink)
+{
+    int err = 0;
+
+    if ((sink->len > 0) && (sink->conn != NULL)) {
+        err = bt_nus_send(sink->conn, sink->buf, sink->len);
+        if ((err == -ENOMEM) || (err == -ENOBUFS) || (err == -EAGAIN)) {
+            sink->blocked = true;
+            return -EAGAIN;
+        }
+        if (err) {
+            // 連線已中斷或主機未啟用 notification，直接丟棄資料
+            LOG_DBG("NUS send failed: %d", err);
+        }
+    }
+    sink->blocked = false;
+    sink->len = 0;
+    return 0;
+}
+
+void nus_sink_init(struct nus_sink *sink)
+{
+    sink->conn = NULL;
+    sink->len = 0;
+    sink->pending_since = 0;
+    sink->blocked = false;
+    k_mutex_init(&sink->lock);
+}
+
+void nus_sink_set_conn(struct nus_sink *sink, struct bt_conn *conn)
+{
+    k_mutex_lock(&sink->lock, K_FOREVER);
+    if (sink->conn != conn) {
+        if (sink->conn != NULL) {
+            bt_conn_unref(sink->conn);
+        }
+        sink->conn = (conn != NULL) ? bt_conn_ref(conn) : NULL;
+        sink->len = 0;
+        sink->blocked = false;
+    }
+    k_mutex_unlock(&sink->lock);
+}
+
+struct bt_conn *nus_sink_get_conn(struct nus_sink *sink)
+{
+    return sink->conn;
+}
+
+size_t nus_sink_write(struct nus_sink *sink, const uint8_t *data, size_t len)
+{
+    size_t chunk;
+    size_t n;
+    size_t left = len;
+
+    k_mutex_lock(&sink->lock, K_FOREVER);
+    if (sink->conn == NULL) {
+        k_mutex_unlock(&sink->lock);
+        return len;
+    }
+
+    chunk = nus_sink_chunk_size(sink);
+    while (left > 0) {
+        // 湊滿一個 MTU 區塊就立即發送；藍牙發送緩衝區用完時停止接受，剩餘資料由呼叫端稍後重試
+        if ((sink->len >= chunk) && (nus_sink_send_locked(sink) != 0)) {
+            break;
+        }
+        if (sink->len == 0) {
+            sink->pending_since = k_uptime_get_32();
+        }
+        n = MIN(left, chunk - MIN(sink->len, chunk));
+        memcpy(&sink->buf[sink->len], data, n);
+        sink->len += n;
+        data += n;
+        left -= n;
+    }
+    if (sink->len >= chunk) {
+        nus_sink_send_locked(sink);
+    }
+    k_mutex_unlock(&sink->lock);
+
+    return len - left;
+}
+
+bool nus_sink_is_blocked(struct nus_sink *sink)
+{
+    return sink->blocked;
+}
+
+void nus_sink_service(struct nus_sink *sink, bool force)
+{
+    k_mutex_lock(&sink->lock, K_FOREVER);
+    if ((sink->len > 0) && (force || sink->blocked || ((k_uptime_get_32() - sink->pending_since) >= NUS_SINK_FLUSH_TIMEOUT_MS))) {
+        nus_sink_send_locked(sink);
+    }
+    k_mutex_unlock(&sink->lock);
+}
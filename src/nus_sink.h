@@ -0,0 +1,85 @@
+#ifndef NUS_SINK_H__
+#define NUS_SINK_H__
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/conn.h>
+
+// 單一 notification 的最大資料長度 (ATT MTU 扣除 3 位元組標頭)
+#define NUS_SINK_BUF_SIZE (CONFIG_BT_L2CAP_TX_MTU - 3)
+// 緩衝資料在未湊滿一個 MTU 前最長的等待時間 (毫秒)
+#define NUS_SINK_FLUSH_TIMEOUT_MS (CONFIG_NUS_SINK_FLUSH_TIMEOUT_MS)
+// 藍牙發送緩衝區用完後重試發送的間隔 (毫秒)
+#define NUS_SINK_RETRY_MS (5)
+
+/**
+ * @brief NUS 回應輸出端的數據結構。
+ * 將 AT 回應累積成 ATT MTU 大小的區塊，再以 bt_nus_send() 發送給指定連線。
+ */
+struct nus_sink {
+    struct bt_conn *conn;             // 目標連線，NULL 表示沒有連線 (寫入的資料會被丟棄)
+    uint8_t buf[NUS_SINK_BUF_SIZE];   // 等待發送的資料
+    size_t len;                       // 目前緩衝的資料長度
+    uint32_t pending_since;           // 緩衝區第一個位元組寫入的時間 (k_uptime_get_32)
+    bool blocked;                     // 上次發送因藍牙發送緩衝區用完而失敗，資料保留在 buf
+    struct k_mutex lock;              // 保護連線指針與緩衝區
+};
+
+/**
+ * @brief 初始化 NUS 回應輸出端。
+ *
+ * @param sink 指向輸出端數據結構的指針。
+ */
+void nus_sink_init(struct nus_sink *sink);
+
+/**
+ * @brief 設定輸出端的目標連線。
+ *
+ * 會持有連線的參考，傳入 NULL 時釋放目前的連線並丟棄未發送的資料。
+ *
+ * @param sink 指向輸出端數據結構的指針。
+ * @param conn 目標連線，或 NULL。
+ */
+void nus_sink_set_conn(struct nus_sink *sink, struct bt_conn *conn);
+
+/**
+ * @brief 取得輸出端目前的目標連線 (不增加參考計數)。
+ *
+ * @param sink 指向輸出端數據結構的指針。
+ *
+ * @return 目前的連線，或 NULL。
+ */
+struct bt_conn *nus_sink_get_conn(struct nus_sink *sink);
+
+/**
+ * @brief 寫入要發送給 BLE 主機的資料。
+ *
+ * 資料湊滿一個 MTU 區塊時立即發送，其餘部分留在緩衝區等待 nus_sink_service()。
+ * 藍牙發送緩衝區用完時保留已緩衝的資料並停止接受，輸出端進入阻塞狀態；
+ * 沒有連線或主機未啟用 notification 時資料會被丟棄。
+ *
+ * @param sink 指向輸出端數據結構的指針。
+ * @param data 要發送的資料。
+ * @param len 資料長度。
+ *
+ * @return 接受的位元組數，阻塞時可能小於 len。
+ */
+size_t nus_sink_write(struct nus_sink *sink, const uint8_t *data, size_t len);
+
+/**
+ * @brief 檢查輸出端是否因藍牙發送緩衝區用完而阻塞。
+ *
+ * 阻塞時呼叫端應在 NUS_SINK_RETRY_MS 後呼叫 nus_sink_service() 或再次寫入以重試發送。
+ *
+ * @param sink 指向輸出端數據結構的指針。
+ */
+bool nus_sink_is_blocked(struct nus_sink *sink);
+
+/**
+ * @brief 發送緩衝區中未滿一個區塊的資料。
+ *
+ * @param sink 指向輸出端數據結構的指針。
+ * @param force true 時立即發送，否則只有在資料等待超過 NUS_SINK_FLUSH_TIMEOUT_MS 或輸出端阻塞時才發送。
+ */
+void nus_sink_service(struct nus_sink *sink, bool force);
+
+#endif // NUS_SINK_H__
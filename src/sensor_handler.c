@@ -1,11 +1,288 @@
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <errno.h>
 #include <stdint.h>
+#include "hmi_uart.h"
 #include "sensor_handler.h"
+#include "value_reporter.h"
 
-int sensor_handler_update_value(void);
+LOG_MODULE_REGISTER(sensor_handler, LOG_LEVEL_INF);
+
+// --- Zephyr 相關定義 ---
+#define SENSOR_HANDLER_STACK_SIZE 2048
+// 比 value_reporter 與 AT 解析器優先，快取寫入不會被讀取端打斷
+#define SENSOR_HANDLER_PRIORITY 6
+
+// ATM90E26 UART 協定
+// 讀取請求：<0xFE> <0x80 | addr> <checksum = 0x80 | addr>
+// 讀取回覆：<data MSB> <data LSB> <checksum = (MSB + LSB) & 0xFF>
+#define ATM90E26_UART_START 0xFE
+#define ATM90E26_UART_READ  0x80
+#define ATM90E26_READ_REQ_LEN 3
+#define ATM90E26_READ_RSP_LEN 3
+
+// 一次交易中連續送出的讀取請求數
+#define SENSOR_PIPELINE_DEPTH CONFIG_SENSOR_HANDLER_PIPELINE_DEPTH
+#define SENSOR_BAUD_RATE CONFIG_SENSOR_HANDLER_BAUD_RATE
+// 每個 UART 的收發環形緩衝區大小，至少要放得下一批請求或回覆
+#define SENSOR_UART_RBUF_SIZE 64
+BUILD_ASSERT(SENSOR_PIPELINE_DEPTH * ATM90E26_READ_RSP_LEN <= SENSOR_UART_RBUF_SIZE,
+             "one pipelined batch must fit in the UART ring buffers");
+// 一批交易的逾時：請求與回覆的傳輸時間 (每個位元組 10 bits) 加上晶片回應裕度
+#define SENSOR_BATCH_TIMEOUT_MS \
+    ((SENSOR_PIPELINE_DEPTH * (ATM90E26_READ_REQ_LEN + ATM90E26_READ_RSP_LEN) * 10U * MSEC_PER_SEC) / SENSOR_BAUD_RATE \
+     + CONFIG_SENSOR_HANDLER_RSP_TIMEOUT_MS)
+
+#define SENSOR_UART_DEFINE(name, node)                                  \
+    RING_BUF_DECLARE(name##_rx_rbuf, SENSOR_UART_RBUF_SIZE);            \
+    RING_BUF_DECLARE(name##_tx_rbuf, SENSOR_UART_RBUF_SIZE);            \
+    K_SEM_DEFINE(name##_rx_sem, 0, 1);                                  \
+    static struct hmi_uart_data name = {                                \
+        .dev = DEVICE_DT_GET(node),                                     \
+        .rx_rbuf = &name##_rx_rbuf,                                     \
+        .rx_sem = &name##_rx_sem,                                       \
+        .tx_rbuf = &name##_tx_rbuf,                                     \
+    }
+
+// 感測器 0 使用 uart20、感測器 1 使用 uart21；board overlay 沒有啟用或被主控台佔用的 UART 不建立實例
+#define SENSOR_UART_USABLE(node) \
+    (DT_NODE_HAS_STATUS(node, okay) && !DT_SAME_NODE(node, DT_CHOSEN(zephyr_console)))
+
+#if SENSOR_UART_USABLE(DT_ALIAS(uart20))
+SENSOR_UART_DEFINE(sensor0_uart, DT_ALIAS(uart20));
+#define SENSOR0_UART (&sensor0_uart)
+#else
+#define SENSOR0_UART NULL
+#endif
+
+#if SENSOR_UART_USABLE(DT_ALIAS(uart21))
+SENSOR_UART_DEFINE(sensor1_uart, DT_ALIAS(uart21));
+#define SENSOR1_UART (&sensor1_uart)
+#else
+#define SENSOR1_UART NULL
+#endif
+
+// 每個感測器的匯流排狀態，只由擷取執行緒存取
+struct sensor_bus {
+    struct hmi_uart_data *uart;         // NULL 表示沒有對應的 UART
+    bool ready;                         // UART 初始化成功
+    uint32_t pending;                   // 這一輪還沒讀取的暫存器 (bit = 暫存器索引)
+    uint8_t regs[SENSOR_PIPELINE_DEPTH]; // 目前批次依序讀取的暫存器索引
+    uint8_t batch_len;                  // 目前批次送出的讀取請求數
+    size_t rsp_len;                     // 已收到的回覆位元組數
+    uint8_t rsp[SENSOR_PIPELINE_DEPTH * ATM90E26_READ_RSP_LEN];
+};
+
+// 每個感測器的快照快取：單一寫入者 (擷取執行緒) 以序號保護，讀取端不加鎖
+struct sensor_cache {
+    atomic_t seq;                       // 奇數表示寫入中
+    uint16_t values[TOTAL_REG_NUM];
+    uint32_t updated_ms;                // 最後一次更新的系統運行時間 (ms)
+};
+
+static struct sensor_bus sensor_buses[TOTAL_SENSOR_ID] = {
+    [0] = { .uart = SENSOR0_UART },
+    [1] = { .uart = SENSOR1_UART },
+};
+static struct sensor_cache sensor_caches[TOTAL_SENSOR_ID];
+// 暫存器索引對應的位址，啟動時從 value_reporter 取得一次
+static uint8_t sensor_reg_addr[TOTAL_REG_NUM];
 
 uint16_t sensor_handler_get_reg_value(uint8_t sensorId, uint8_t reg)
 {
-    static uint16_t reg_val = 0x1010;
-    reg_val++;
-    return reg_val;
-}
\ No newline at end of file
+    if (sensorId >= TOTAL_SENSOR_ID || reg >= TOTAL_REG_NUM) {
+        return 0;
+    }
+    // 對齊的 16 位元讀取本身不可分割，單一暫存器不需要檢查序號
+    return *(volatile uint16_t *)&sensor_caches[sensorId].values[reg];
+}
+
+int sensor_handler_get_snapshot(uint8_t sensorId, uint16_t *values, uint32_t *timestamp)
+{
+    struct sensor_cache *cache;
+    atomic_val_t seq;
+
+    if (sensorId >= TOTAL_SENSOR_ID || values == NULL) {
+        return -EINVAL;
+    }
+    if (sensor_buses[sensorId].uart == NULL) {
+        return -ENODEV;
+    }
+
+    cache = &sensor_caches[sensorId];
+    do {
+        seq = atomic_get(&cache->seq);
+        if (seq & 1) {
+            // 寫入端優先權較高，只有在其他 CPU 上才可能看到寫入中
+            k_yield();
+            continue;
+        }
+        for (size_t i = 0; i < TOTAL_REG_NUM; i++) {
+            values[i] = cache->values[i];
+        }
+        if (timestamp != NULL) {
+            *timestamp = cache->updated_ms;
+        }
+    } while ((seq & 1) || (atomic_get(&cache->seq) != seq));
+
+    return 0;
+}
+
+// 丟棄上一批逾時後才到達的位元組，避免回覆錯位
+static void sensor_bus_drain(struct sensor_bus *bus)
+{
+    uint8_t scratch[16];
+
+    while (ring_buf_get(bus->uart->rx_rbuf, scratch, sizeof(scratch)) > 0) {
+    }
+    hmi_uart_rx_resume(bus->uart);
+    k_sem_reset(bus->uart->rx_sem);
+}
+
+// 從 pending 取出最多 SENSOR_PIPELINE_DEPTH 個暫存器一次送出讀取請求，回覆由 sensor_bus_collect() 依序收取
+static void sensor_bus_send_batch(struct sensor_bus *bus)
+{
+    uint8_t req[SENSOR_PIPELINE_DEPTH * ATM90E26_READ_REQ_LEN];
+    size_t len = 0;
+    uint8_t count = 0;
+    int ret;
+
+    sensor_bus_drain(bus);
+    while (bus->pending != 0 && count < SENSOR_PIPELINE_DEPTH) {
+        uint8_t reg = (uint8_t)(find_lsb_set(bus->pending) - 1);
+        uint8_t cmd = ATM90E26_UART_READ | sensor_reg_addr[reg];
+
+        bus->pending &= ~BIT(reg);
+        bus->regs[count++] = reg;
+        req[len++] = ATM90E26_UART_START;
+        req[len++] = cmd;
+        req[len++] = cmd;
+    }
+
+    bus->rsp_len = 0;
+    ret = hmi_uart_send(bus->uart, req, len);
+    bus->batch_len = (ret == (int)len) ? count : 0;
+    if (bus->batch_len == 0) {
+        LOG_WRN("%s: 送出讀取請求失敗: %d", bus->uart->dev->name, ret);
+    }
+}
+
+// 收取目前批次的回覆直到 deadline，校驗正確的暫存器寫入快取
+static void sensor_bus_collect(struct sensor_bus *bus, uint8_t sensor_id, int64_t deadline)
+{
+    struct sensor_cache *cache = &sensor_caches[sensor_id];
+    size_t want = bus->batch_len * ATM90E26_READ_RSP_LEN;
+    size_t done;
+    uint8_t bad = 0;
+
+    while (bus->rsp_len < want) {
+        uint32_t got = ring_buf_get(bus->uart->rx_rbuf, &bus->rsp[bus->rsp_len], want - bus->rsp_len);
+        int64_t now;
+
+        if (got > 0) {
+            bus->rsp_len += got;
+            hmi_uart_rx_resume(bus->uart);
+            continue;
+        }
+        now = k_uptime_get();
+        if (now >= deadline || k_sem_take(bus->uart->rx_sem, K_MSEC(deadline - now)) != 0) {
+            break;
+        }
+    }
+
+    done = bus->rsp_len / ATM90E26_READ_RSP_LEN;
+    if (done == 0) {
+        if (bus->batch_len != 0) {
+            LOG_DBG("%s: 讀取逾時", bus->uart->dev->name);
+        }
+        return;
+    }
+
+    atomic_inc(&cache->seq);
+    for (size_t i = 0; i < done; i++) {
+        const uint8_t *rsp = &bus->rsp[i * ATM90E26_READ_RSP_LEN];
+
+        if ((uint8_t)(rsp[0] + rsp[1]) != rsp[2]) {
+            bad++;
+            continue;
+        }
+        cache->values[bus->regs[i]] = ((uint16_t)rsp[0] << 8) | rsp[1];
+    }
+    cache->updated_ms = (uint32_t)k_uptime_get();
+    atomic_inc(&cache->seq);
+
+    if (bad != 0 || done < bus->batch_len) {
+        LOG_DBG("%s: %u 筆校驗錯誤，%u 筆未回覆", bus->uart->dev->name, bad, (unsigned int)(bus->batch_len - done));
+    }
+}
+
+// --- 擷取執行緒 ---
+static void sensor_handler_thread(void *p1, void *p2, void *p3)
+{
+    bool any_ready = false;
+    int64_t next_poll;
+
+    for (uint8_t i = 0; i < TOTAL_REG_NUM; i++) {
+        sensor_reg_addr[i] = (uint8_t)value_reporter_get_register_addr(i);
+    }
+
+    for (uint8_t id = 0; id < TOTAL_SENSOR_ID; id++) {
+        struct sensor_bus *bus = &sensor_buses[id];
+
+        if (bus->uart == NULL) {
+            continue;
+        }
+        bus->ready = (hmi_uart_init_instance(bus->uart, SENSOR_BAUD_RATE) == 0);
+        any_ready |= bus->ready;
+    }
+    if (!any_ready) {
+        LOG_WRN("沒有可用的 ATM90E26 UART，停止擷取");
+        return;
+    }
+
+    next_poll = k_uptime_get();
+    while (true) {
+        bool pending = false;
+
+        // 只輪詢啟用回報的暫存器，9600 bps 下每個暫存器約佔 6.25 ms，全部 21 個要 131 ms
+        for (uint8_t id = 0; id < TOTAL_SENSOR_ID; id++) {
+            struct sensor_bus *bus = &sensor_buses[id];
+
+            bus->pending = bus->ready ? value_reporter_get_poll_mask(id) & BIT_MASK(TOTAL_REG_NUM) : 0;
+            pending |= (bus->pending != 0);
+        }
+
+        // 每一批先對所有感測器送出請求，再依序收取回覆，各條 UART 的傳輸互相重疊
+        while (pending) {
+            int64_t deadline;
+
+            pending = false;
+            for (uint8_t id = 0; id < TOTAL_SENSOR_ID; id++) {
+                sensor_buses[id].batch_len = 0;
+                if (sensor_buses[id].pending != 0) {
+                    sensor_bus_send_batch(&sensor_buses[id]);
+                }
+            }
+            deadline = k_uptime_get() + SENSOR_BATCH_TIMEOUT_MS;
+            for (uint8_t id = 0; id < TOTAL_SENSOR_ID; id++) {
+                if (sensor_buses[id].batch_len != 0) {
+                    sensor_bus_collect(&sensor_buses[id], id, deadline);
+                }
+                pending |= (sensor_buses[id].pending != 0);
+            }
+        }
+
+        // 以固定間隔累加避免漂移，一輪耗時超過間隔時立即開始下一輪
+        next_poll += CONFIG_SENSOR_HANDLER_POLL_INTERVAL_MS;
+        if (next_poll < k_uptime_get()) {
+            next_poll = k_uptime_get();
+        }
+        k_sleep(K_TIMEOUT_ABS_MS(next_poll));
+    }
+}
+
+K_THREAD_DEFINE(sensor_handler_tid, SENSOR_HANDLER_STACK_SIZE, sensor_handler_thread, NULL, NULL, NULL, SENSOR_HANDLER_PRIORITY, 0, 0);
@@ -1,6 +1,29 @@
 #ifndef SENSOR_HANDLER_H__
 #define SENSOR_HANDLER_H__
 #include <stdint.h>
+#include <stdbool.h>
 
+/**
+ * @brief 讀取快取中的暫存器值。
+ *
+ * 數值由擷取執行緒經由 UART 週期性輪詢 ATM90E26 後寫入快取，
+ * 呼叫端只讀取快取，不會等待匯流排，成本為 O(1)。
+ * 只有 value_reporter_get_poll_mask() 中啟用回報的暫存器會被輪詢，其餘保留最後讀到的值。
+ * 沒有對應 UART 或尚未讀取成功的暫存器回傳 0。
+ *
+ * @param sensorId 感測器編號 (0 ~ TOTAL_SENSOR_ID - 1)
+ * @param reg 暫存器索引 (0 ~ TOTAL_REG_NUM - 1)，位址可由 value_reporter_get_register_addr() 取得
+ */
 uint16_t sensor_handler_get_reg_value(uint8_t sensorId, uint8_t reg);
+
+/**
+ * @brief 取得一個感測器所有暫存器的一致快照 (不加鎖)。
+ *
+ * @param sensorId 感測器編號
+ * @param values 輸出緩衝區，至少 TOTAL_REG_NUM 筆
+ * @param timestamp 輸出最後一次更新的系統運行時間 (ms)，可為 NULL
+ *
+ * @return 0 表示成功，-EINVAL 表示參數不合法，-ENODEV 表示感測器沒有對應的 UART。
+ */
+int sensor_handler_get_snapshot(uint8_t sensorId, uint16_t *values, uint32_t *timestamp);
 #endif // SENSOR_HANDLER_H__
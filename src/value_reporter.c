@@ -1,18 +1,99 @@
-#include <stdio.h>
 #include <stdint.h>
 #include <string.h>
+#include <errno.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
 #include "value_reporter.h"
 #include "sensor_handler.h"
+#include "numfmt.h"
 
 LOG_MODULE_REGISTER(value_reporter, LOG_LEVEL_INF);
 
+// 回報工作佇列的執行緒設定，暫存器掃描與格式化都在這個執行緒中進行
+#define VALUE_REPORTER_STACK_SIZE 2048
+#define VALUE_REPORTER_PRIORITY 8
+
+K_THREAD_STACK_DEFINE(value_reporter_stack, VALUE_REPORTER_STACK_SIZE);
+static struct k_work_q value_reporter_work_q;
+static bool value_reporter_started = false;
+// 回報送出的目的地，未設定時只記錄在日誌
+static value_reporter_output_t report_output = NULL;
+static enum value_reporter_format report_format = VALUE_REPORTER_FORMAT_TEXT;
+
+// 依到期時間排序的回報排程 (最小堆積)，只包含已啟用的 (感測器, 暫存器)
+struct report_entry {
+    uint32_t deadline;  // 下一次回報的系統運行時間 (ms，會回繞)
+    uint8_t sensor_id;
+    uint8_t reg_idx;
+};
+static struct report_entry report_heap[TOTAL_SENSOR_ID * TOTAL_REG_NUM];
+static size_t report_heap_len = 0;
+// 每個 (感測器, 暫存器) 在堆積中的位置加一，0 代表未排程
+static uint16_t report_heap_pos[TOTAL_SENSOR_ID][TOTAL_REG_NUM];
+// 保護排程資料，設定週期 (AT 解析器執行緒) 與回報 (工作佇列) 會同時存取
+K_MUTEX_DEFINE(report_lock);
+
+// 週期與上次回報時間都以各項目自己的時間單位 (秒或毫秒) 記錄
 static uint32_t report_last_tick[TOTAL_SENSOR_ID][TOTAL_REG_NUM];
 static uint32_t report_periods[TOTAL_SENSOR_ID][TOTAL_REG_NUM];
+// 每個感測器啟用回報的暫存器 (bit = 暫存器索引)，擷取執行緒不加鎖讀取
+static atomic_t report_poll_mask[TOTAL_SENSOR_ID];
+BUILD_ASSERT(TOTAL_REG_NUM <= 32, "report_poll_mask holds one bit per register");
+static uint8_t report_units[TOTAL_SENSOR_ID][TOTAL_REG_NUM];
+// 變化觸發回報：數值變化超過 deadband 或超過 max_silence 沒有回報時才送出 (deadband 為 0 時每個週期都回報)
+static uint16_t report_deadband[TOTAL_SENSOR_ID][TOTAL_REG_NUM];
+static uint32_t report_max_silence[TOTAL_SENSOR_ID][TOTAL_REG_NUM];
+static uint16_t report_last_value[TOTAL_SENSOR_ID][TOTAL_REG_NUM];
+static uint32_t report_last_sent_tick[TOTAL_SENSOR_ID][TOTAL_REG_NUM];
+static bool report_sent[TOTAL_SENSOR_ID][TOTAL_REG_NUM];
+
+// 統計回報：內部取樣時以 O(1) 累計，回報時換算成統計值後歸零
+struct report_accumulator {
+    uint16_t min;
+    uint16_t max;
+    uint32_t count;
+    uint64_t sum;
+    uint64_t sum_sq;
+};
+static struct report_accumulator report_acc[TOTAL_SENSOR_ID][TOTAL_REG_NUM];
+static bool report_aggregate[TOTAL_SENSOR_ID][TOTAL_REG_NUM];
+// 需要內部取樣的項目 (sensor_id * TOTAL_REG_NUM + reg_idx)，只在設定改變時更新
+static uint16_t agg_entries[TOTAL_SENSOR_ID * TOTAL_REG_NUM];
+static size_t agg_entry_num = 0;
+static int64_t agg_next_sample_ms = 0;
+// 每個感測器上次累計的快照更新時間，快取沒有更新時不重複累計同一筆數值
+static uint32_t agg_sampled_ms[TOTAL_SENSOR_ID];
+BUILD_ASSERT(REPORT_FRAME_OVERHEAD + REPORT_AGG_FRAME_MAX_RECORDS * REPORT_AGG_RECORD_LEN <= REPORT_FRAME_MAX_LEN,
+             "aggregate frames share the report frame buffers");
 
-static int value_reporter_make_report(char *buff, size_t buff_size, uint8_t sensorId, uint8_t reg, uint16_t val, uint32_t period);
+// 取樣歷史：每個啟用的 (感測器, 暫存器) 從池中分配一個環形緩衝區，樣本連續存放方便批次讀取
+struct history_sample {
+    uint32_t timestamp;
+    uint16_t value;
+};
+struct history_ring {
+    uint32_t count;  // 累計寫入的樣本數，最新樣本位於 (count - 1) % VALUE_REPORTER_HISTORY_DEPTH
+    struct history_sample samples[VALUE_REPORTER_HISTORY_DEPTH];
+};
+static struct history_ring history_pool[VALUE_REPORTER_HISTORY_SLOTS];
+static uint32_t history_used_mask = 0;
+BUILD_ASSERT(VALUE_REPORTER_HISTORY_SLOTS <= 32, "history_used_mask holds one bit per slot");
+// 每個 (感測器, 暫存器) 使用的歷史緩衝區編號加一，0 代表沒有
+static uint8_t history_slot[TOTAL_SENSOR_ID][TOTAL_REG_NUM];
+
+static int value_reporter_append_report(char *line, size_t line_size, size_t *line_len, uint8_t sensorId, uint8_t reg, uint16_t val, uint32_t period, enum value_reporter_unit unit);
+static int value_reporter_append_agg_report(char *line, size_t line_size, size_t *line_len, const struct value_reporter_aggregate *agg);
 static int atm90e26_get_register_index(enum ATM90E26_ENG_REGSTERS reg);
 static bool value_reporter_check_reg_need_report(uint8_t sensor_id, uint8_t reg, uint32_t last_tick, uint32_t current_tick);
-static void value_reporter_timer_handler(void *p1, void *p2, void *p3);
+static bool value_reporter_check_value_need_report(uint8_t sensor_id, uint8_t reg_idx, uint16_t val, uint32_t current_tick);
+static void value_reporter_work_handler(struct k_work *work);
+static void value_reporter_sample_handler(struct k_work *work);
+static void value_reporter_schedule_next(void);
+static void value_reporter_schedule_sampling(bool advance);
+
+K_WORK_DELAYABLE_DEFINE(value_reporter_work, value_reporter_work_handler);
+K_WORK_DELAYABLE_DEFINE(value_reporter_sample_work, value_reporter_sample_handler);
 
 static const enum ATM90E26_ENG_REGSTERS register_map[] = {
     APENG,   ANENG,   ATENG,
@@ -52,7 +133,257 @@ static int atm90e26_get_register_index(enum ATM90E26_ENG_REGSTERS reg) {
     }
 }
 
+static uint32_t value_reporter_unit_ms(uint8_t unit)
+{
+    return (unit == VALUE_REPORTER_UNIT_MS) ? 1 : MSEC_PER_SEC;
+}
+
+// 以系統運行時間換算成指定單位的 tick，不受計時器誤差累積影響
+static uint32_t value_reporter_get_tick(uint8_t unit)
+{
+    return (uint32_t)(k_uptime_get() / value_reporter_unit_ms(unit));
+}
+
+// 項目下一次回報的時間 (ms)
+static uint32_t report_deadline_ms(uint8_t sensor_id, uint8_t reg_idx)
+{
+    return (report_last_tick[sensor_id][reg_idx] + report_periods[sensor_id][reg_idx])
+           * value_reporter_unit_ms(report_units[sensor_id][reg_idx]);
+}
+
+// tick 會回繞，以差值的正負判斷先後
+static bool report_deadline_before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+static void report_heap_swap(size_t a, size_t b)
+{
+    struct report_entry tmp = report_heap[a];
+    report_heap[a] = report_heap[b];
+    report_heap[b] = tmp;
+    report_heap_pos[report_heap[a].sensor_id][report_heap[a].reg_idx] = a + 1;
+    report_heap_pos[report_heap[b].sensor_id][report_heap[b].reg_idx] = b + 1;
+}
+
+// 到期時間改變後，把位置 i 的項目往上或往下移到正確位置
+static void report_heap_fix(size_t i)
+{
+    while(i > 0)
+    {
+        size_t parent = (i - 1) / 2;
+        if(!report_deadline_before(report_heap[i].deadline, report_heap[parent].deadline))
+        {
+            break;
+        }
+        report_heap_swap(i, parent);
+        i = parent;
+    }
+
+    for(;;)
+    {
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+        size_t min = i;
+        if(left < report_heap_len && report_deadline_before(report_heap[left].deadline, report_heap[min].deadline))
+        {
+            min = left;
+        }
+        if(right < report_heap_len && report_deadline_before(report_heap[right].deadline, report_heap[min].deadline))
+        {
+            min = right;
+        }
+        if(min == i)
+        {
+            break;
+        }
+        report_heap_swap(i, min);
+        i = min;
+    }
+}
+
+static void report_heap_insert(uint8_t sensor_id, uint8_t reg_idx, uint32_t deadline)
+{
+    size_t i = report_heap_len++;
+    report_heap[i].deadline = deadline;
+    report_heap[i].sensor_id = sensor_id;
+    report_heap[i].reg_idx = reg_idx;
+    report_heap_pos[sensor_id][reg_idx] = i + 1;
+    report_heap_fix(i);
+}
+
+static void report_heap_remove(size_t i)
+{
+    report_heap_pos[report_heap[i].sensor_id][report_heap[i].reg_idx] = 0;
+    report_heap_len--;
+    if(i != report_heap_len)
+    {
+        report_heap[i] = report_heap[report_heap_len];
+        report_heap_pos[report_heap[i].sensor_id][report_heap[i].reg_idx] = i + 1;
+        report_heap_fix(i);
+    }
+}
+
+// 分配歷史緩衝區，池用完時此項目不保存歷史；呼叫端必須持有 report_lock
+static void history_alloc(uint8_t sensor_id, uint8_t reg_idx)
+{
+    for(uint8_t i = 0; i < VALUE_REPORTER_HISTORY_SLOTS; i++)
+    {
+        if((history_used_mask & BIT(i)) == 0)
+        {
+            history_used_mask |= BIT(i);
+            history_pool[i].count = 0;
+            history_slot[sensor_id][reg_idx] = i + 1;
+            return;
+        }
+    }
+    LOG_WRN("No history slot for %u, %02X", sensor_id, register_map[reg_idx]);
+}
+
+static void history_free(uint8_t sensor_id, uint8_t reg_idx)
+{
+    uint8_t slot = history_slot[sensor_id][reg_idx];
+
+    if(slot != 0)
+    {
+        history_used_mask &= ~BIT(slot - 1);
+        history_slot[sensor_id][reg_idx] = 0;
+    }
+}
+
+static void history_push(uint8_t sensor_id, uint8_t reg_idx, uint32_t timestamp, uint16_t val)
+{
+    uint8_t slot = history_slot[sensor_id][reg_idx];
+
+    if(slot != 0)
+    {
+        struct history_ring *ring = &history_pool[slot - 1];
+        struct history_sample *sample = &ring->samples[ring->count % VALUE_REPORTER_HISTORY_DEPTH];
+        sample->timestamp = timestamp;
+        sample->value = val;
+        ring->count++;
+    }
+}
+
+static void accumulator_reset(struct report_accumulator *acc)
+{
+    acc->min = UINT16_MAX;
+    acc->max = 0;
+    acc->count = 0;
+    acc->sum = 0;
+    acc->sum_sq = 0;
+}
+
+static void accumulator_add(struct report_accumulator *acc, uint16_t val)
+{
+    acc->min = MIN(acc->min, val);
+    acc->max = MAX(acc->max, val);
+    acc->count++;
+    acc->sum += val;
+    acc->sum_sq += (uint32_t)val * val;
+}
+
+// 整數平方根 (無條件捨去)
+static uint16_t isqrt32(uint32_t val)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while(bit > val)
+    {
+        bit >>= 2;
+    }
+    while(bit != 0)
+    {
+        if(val >= root + bit)
+        {
+            val -= root + bit;
+            root = (root >> 1) + bit;
+        }else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint16_t)root;
+}
+
+static void accumulator_take(struct report_accumulator *acc, struct value_reporter_aggregate *agg)
+{
+    agg->min = acc->min;
+    agg->max = acc->max;
+    agg->mean = (uint16_t)(acc->sum / acc->count);
+    agg->rms = isqrt32((uint32_t)(acc->sum_sq / acc->count));
+    agg->count = (acc->count > UINT16_MAX) ? UINT16_MAX : acc->count;
+    accumulator_reset(acc);
+}
+
+// 依目前設定加入或移除內部取樣清單；呼叫端必須持有 report_lock
+static void agg_list_update(uint8_t sensor_id, uint8_t reg_idx)
+{
+    uint16_t entry = sensor_id * TOTAL_REG_NUM + reg_idx;
+    bool wanted = report_aggregate[sensor_id][reg_idx] && (report_periods[sensor_id][reg_idx] != 0);
+    size_t i;
+
+    for(i = 0; i < agg_entry_num; i++)
+    {
+        if(agg_entries[i] == entry)
+        {
+            break;
+        }
+    }
+
+    if(wanted && i == agg_entry_num)
+    {
+        agg_entries[agg_entry_num++] = entry;
+        accumulator_reset(&report_acc[sensor_id][reg_idx]);
+    }else if(!wanted && i != agg_entry_num)
+    {
+        agg_entries[i] = agg_entries[--agg_entry_num];
+    }
+    value_reporter_schedule_sampling(false);
+}
+
+// 更新單一項目的排程，週期為 0 時從排程中移除，restart 時從現在重新起算；呼叫端必須持有 report_lock
+static void report_schedule_update(uint8_t sensor_id, uint8_t reg_idx, bool restart)
+{
+    uint32_t period = report_periods[sensor_id][reg_idx];
+    uint16_t pos = report_heap_pos[sensor_id][reg_idx];
+
+    if(period == 0)
+    {
+        if(pos != 0)
+        {
+            report_heap_remove(pos - 1);
+            history_free(sensor_id, reg_idx);
+        }
+        return;
+    }
+
+    if(pos == 0 || restart)
+    {
+        // 新啟用的項目在下一個 tick 就回報 (與原本計時器第一次到期時相同)，之後每個週期一次，第一次取樣一定送出
+        report_last_tick[sensor_id][reg_idx] = value_reporter_get_tick(report_units[sensor_id][reg_idx]) + 1 - period;
+        report_sent[sensor_id][reg_idx] = false;
+    }
+
+    if(pos == 0)
+    {
+        report_heap_insert(sensor_id, reg_idx, report_deadline_ms(sensor_id, reg_idx));
+        history_alloc(sensor_id, reg_idx);
+    }else
+    {
+        report_heap[pos - 1].deadline = report_deadline_ms(sensor_id, reg_idx);
+        report_heap_fix(pos - 1);
+    }
+}
+
 uint32_t value_reporter_set_report_period(uint8_t sensorId, uint8_t reg, uint32_t period)
+{
+    return value_reporter_set_report_period_unit(sensorId, reg, period, VALUE_REPORTER_UNIT_S);
+}
+
+uint32_t value_reporter_set_report_period_unit(uint8_t sensorId, uint8_t reg, uint32_t period, enum value_reporter_unit unit)
 {
     int reg_index = 0;
     reg_index = atm90e26_get_register_index(reg);
@@ -65,36 +396,232 @@ uint32_t value_reporter_set_report_period(uint8_t sensorId, uint8_t reg, uint32_
     {
         return PERIOD_NOT_VALIDE;
     }
+    if(unit != VALUE_REPORTER_UNIT_S && unit != VALUE_REPORTER_UNIT_MS)
+    {
+        return PERIOD_NOT_VALIDE;
+    }
+
+    if(unit == VALUE_REPORTER_UNIT_MS && period != PERIOD_DISABLE_REPORT && period < MIN_PERIOD_MS)
+    {
+        return PERIOD_NOT_VALIDE;
+    }
+
+    // 回報行的 interval 欄位只有 4 位數，秒與毫秒皆不可超過 MAX_PERIOD
+    if(period > MAX_PERIOD)
+    {
+        return PERIOD_NOT_VALIDE;
+    }
+
+    k_mutex_lock(&report_lock, K_FOREVER);
+    bool unit_changed = (report_units[sensorId][reg_index] != unit);
     report_periods[sensorId][reg_index] = period;
+    report_units[sensorId][reg_index] = unit;
+    if(period != PERIOD_DISABLE_REPORT)
+    {
+        atomic_or(&report_poll_mask[sensorId], BIT(reg_index));
+    }else
+    {
+        atomic_and(&report_poll_mask[sensorId], ~BIT(reg_index));
+    }
+    report_schedule_update(sensorId, reg_index, unit_changed);
+    agg_list_update(sensorId, reg_index);
+    value_reporter_schedule_next();
+    k_mutex_unlock(&report_lock);
     LOG_DBG("Set period: %u, %02X, %u, %u", sensorId, reg, reg_index, period);
     return report_periods[sensorId][reg_index];
 }
 
-static int value_reporter_make_report(char *buff, size_t buff_size, uint8_t sensorId, uint8_t reg, uint16_t val, uint32_t period)
+// 組出 <reg>,<value>,<interval>[,1]，回傳長度 (不含 '\0')；buff 至少 REPORT_GROUP_MAX_LEN + 1 bytes
+#define REPORT_GROUP_MAX_LEN (2U + 1U + 4U + 1U + 4U + 2U)
+static size_t value_reporter_format_group(char *buff, uint8_t reg, uint16_t val, uint32_t period, enum value_reporter_unit unit)
+{
+    size_t len = 0;
+
+    numfmt_u32_to_hex(&buff[len], reg, 2);
+    len += 2;
+    buff[len++] = ',';
+    numfmt_u32_to_hex(&buff[len], val, 4);
+    len += 4;
+    buff[len++] = ',';
+    len += numfmt_u32_to_dec_pad(&buff[len], period, 4);
+    if(unit == VALUE_REPORTER_UNIT_MS)
+    {
+        buff[len++] = ',';
+        buff[len++] = '1';
+    }
+    buff[len] = '\0';
+    return len;
+}
+
+// 組出 "+SYSREG:0,<SensorID>,"，回傳長度 (不含 '\0')
+#define REPORT_HEADER_MAX_LEN (10U + 3U + 1U)
+static size_t value_reporter_format_header(char *buff, uint8_t sensorId)
+{
+    size_t len = sizeof("+SYSREG:0,") - 1;
+
+    memcpy(buff, "+SYSREG:0,", len);
+    len += numfmt_u32_to_dec(&buff[len], sensorId);
+    buff[len++] = ',';
+    buff[len] = '\0';
+    return len;
+}
+
+// 把一組資料接到回報行後面：第一組加上標頭，之後的組以 ';' 分隔；放不下時回傳 -1
+static int value_reporter_append_group(char *line, size_t line_size, size_t *line_len, const char *header, size_t header_len, const char *group, size_t group_len)
+{
+    if(*line_len == 0)
+    {
+        if(header_len + group_len >= line_size)
+        {
+            line[0] = '\0';
+            return -1;
+        }
+        memcpy(line, header, header_len);
+    }else
+    {
+        if(*line_len + 1 + group_len >= line_size)
+        {
+            return -1;
+        }
+        line[(*line_len)++] = ';';
+        header_len = 0;
+    }
+
+    memcpy(&line[*line_len + header_len], group, group_len + 1);
+    *line_len += header_len + group_len;
+    return 0;
+}
+
+static int value_reporter_append_report(char *line, size_t line_size, size_t *line_len, uint8_t sensorId, uint8_t reg, uint16_t val, uint32_t period, enum value_reporter_unit unit)
 {
-    int ret = -1;
-    //+SYSREG:<r/w (r:0, w:1)>,<SensorID (0~2)>,<reg (hex)>,<value (hex)>,<interval (s)>
-    //+SYSREG:1,2,4E,32ED,9999\n
-    if((buff == NULL) || (buff_size < MAX_REPORT_LEN))
+    //+SYSREG:0,<SensorID>,<reg>,<value>,<interval>[,<unit>][;<reg>,<value>,<interval>[,<unit>]]...
+    //+SYSREG:0,2,4E,32ED,9999;48,0007,0100,1
+    char group[REPORT_GROUP_MAX_LEN + 1];
+    char header[REPORT_HEADER_MAX_LEN + 1];
+    size_t group_len = 0;
+    size_t header_len = 0;
+
+    if((line == NULL) || (line_len == NULL) || (*line_len >= line_size))
     {
         return -1;
     }
 
-    if(period > MAX_PERIOD || period < 0)
+    if(period > MAX_PERIOD)
     {
         return -1;
     }
 
-    ret = snprintf(buff, MAX_REPORT_LEN
-        , "+SYSREG:0,%01u,%02X,%04X,%04u\n"
-        ,sensorId, reg, val, period);
+    group_len = value_reporter_format_group(group, reg, val, period, unit);
+    header_len = value_reporter_format_header(header, sensorId);
+    return value_reporter_append_group(line, line_size, line_len, header, header_len, group, group_len);
+}
+
+// 組出 <reg>,<min>,<max>,<mean>,<rms>,<count>，回傳長度 (不含 '\0')；buff 至少 REPORT_AGG_GROUP_MAX_LEN + 1 bytes
+#define REPORT_AGG_GROUP_MAX_LEN (2U + 4U * 5U + 1U + NUMFMT_U32_DEC_MAX_LEN)
+static size_t value_reporter_format_agg_group(char *buff, const struct value_reporter_aggregate *agg)
+{
+    const uint16_t fields[] = { agg->min, agg->max, agg->mean, agg->rms };
+    size_t len = 0;
+
+    numfmt_u32_to_hex(&buff[len], agg->reg, 2);
+    len += 2;
+    for(size_t i = 0; i < ARRAY_SIZE(fields); i++)
+    {
+        buff[len++] = ',';
+        numfmt_u32_to_hex(&buff[len], fields[i], 4);
+        len += 4;
+    }
+    buff[len++] = ',';
+    len += numfmt_u32_to_dec(&buff[len], agg->count);
+    buff[len] = '\0';
+    return len;
+}
+
+static int value_reporter_append_agg_report(char *line, size_t line_size, size_t *line_len, const struct value_reporter_aggregate *agg)
+{
+    //+SYSAGG:<SensorID>,<reg>,<min>,<max>,<mean>,<rms>,<count>[;<reg>,<min>,<max>,<mean>,<rms>,<count>]...
+    //+SYSAGG:2,4A,0100,0180,0140,0142,100;4B,0010,0020,0018,0018,100
+    char group[REPORT_AGG_GROUP_MAX_LEN + 1];
+    char header[REPORT_HEADER_MAX_LEN + 1];
+    size_t group_len = 0;
+    size_t header_len = sizeof("+SYSAGG:") - 1;
 
-    if(ret <= 0)
+    if((line == NULL) || (line_len == NULL) || (agg == NULL) || (*line_len >= line_size))
     {
         return -1;
     }
 
-    return 0;
+    group_len = value_reporter_format_agg_group(group, agg);
+    memcpy(header, "+SYSAGG:", header_len);
+    header_len += numfmt_u32_to_dec(&header[header_len], agg->sensor_id);
+    header[header_len++] = ',';
+    return value_reporter_append_group(line, line_size, line_len, header, header_len, group, group_len);
+}
+
+int value_reporter_make_agg_frame(uint8_t *buff, size_t buff_size, const struct value_reporter_aggregate *aggs, size_t count)
+{
+    size_t len = 0;
+
+    if((buff == NULL) || (aggs == NULL) || (count == 0) || (count > REPORT_AGG_FRAME_MAX_RECORDS))
+    {
+        return -1;
+    }
+
+    if(buff_size < REPORT_FRAME_OVERHEAD + count * REPORT_AGG_RECORD_LEN)
+    {
+        return -1;
+    }
+
+    buff[len++] = REPORT_AGG_FRAME_SYNC;
+    buff[len++] = (uint8_t)count;
+    for(size_t i = 0; i < count; i++)
+    {
+        buff[len++] = aggs[i].sensor_id;
+        buff[len++] = aggs[i].reg;
+        sys_put_le16(aggs[i].min, &buff[len]);
+        sys_put_le16(aggs[i].max, &buff[len + 2]);
+        sys_put_le16(aggs[i].mean, &buff[len + 4]);
+        sys_put_le16(aggs[i].rms, &buff[len + 6]);
+        sys_put_le16(aggs[i].count, &buff[len + 8]);
+        sys_put_le32(aggs[i].timestamp, &buff[len + 10]);
+        len += REPORT_AGG_RECORD_LEN - 2;
+    }
+    sys_put_le16(crc16_ccitt(0xFFFF, &buff[1], len - 1), &buff[len]);
+    len += 2;
+
+    return (int)len;
+}
+
+int value_reporter_make_frame(uint8_t *buff, size_t buff_size, const struct value_reporter_sample *samples, size_t count)
+{
+    size_t len = 0;
+
+    if((buff == NULL) || (samples == NULL) || (count == 0) || (count > REPORT_FRAME_MAX_SAMPLES))
+    {
+        return -1;
+    }
+
+    if(buff_size < REPORT_FRAME_OVERHEAD + count * REPORT_FRAME_SAMPLE_LEN)
+    {
+        return -1;
+    }
+
+    buff[len++] = REPORT_FRAME_SYNC;
+    buff[len++] = (uint8_t)count;
+    for(size_t i = 0; i < count; i++)
+    {
+        buff[len++] = samples[i].sensor_id;
+        buff[len++] = samples[i].reg;
+        sys_put_le16(samples[i].value, &buff[len]);
+        len += 2;
+        sys_put_le32(samples[i].timestamp, &buff[len]);
+        len += 4;
+    }
+    // CRC 涵蓋樣本數與所有樣本，不含同步位元組
+    sys_put_le16(crc16_ccitt(0xFFFF, &buff[1], len - 1), &buff[len]);
+    len += 2;
+
+    return (int)len;
 }
 
 static bool value_reporter_check_reg_need_report(uint8_t sensor_id, uint8_t reg, uint32_t last_tick, uint32_t current_tick)
@@ -131,32 +658,396 @@ static bool value_reporter_check_reg_need_report(uint8_t sensor_id, uint8_t reg,
     return false;
 }
 
-static void value_reporter_timer_handler(void *p1, void *p2, void *p3) {
+// 依堆積頂端的到期時間安排下一次喚醒，沒有啟用的項目時不喚醒；呼叫端必須持有 report_lock
+static void value_reporter_schedule_next(void)
+{
+    if(!value_reporter_started)
+    {
+        return;
+    }
 
-    static uint32_t current_tick = 0;
-    char report_buff[MAX_REPORT_LEN] = {0};
-    for(int id = 0; id < TOTAL_SENSOR_ID; id++)
+    if(report_heap_len == 0)
+    {
+        k_work_cancel_delayable(&value_reporter_work);
+        return;
+    }
+
+    int32_t delay = (int32_t)(report_heap[0].deadline - (uint32_t)k_uptime_get());
+    if(delay < 0)
+    {
+        delay = 0;
+    }
+    k_work_reschedule_for_queue(&value_reporter_work_q, &value_reporter_work, K_MSEC(delay));
+}
+
+// 判斷取樣值是否需要送出，並在需要時記錄為最後送出的值；呼叫端必須持有 report_lock
+static bool value_reporter_check_value_need_report(uint8_t sensor_id, uint8_t reg_idx, uint16_t val, uint32_t current_tick)
+{
+    uint16_t deadband = report_deadband[sensor_id][reg_idx];
+    uint32_t max_silence = report_max_silence[sensor_id][reg_idx];
+
+    if(deadband != 0 && report_sent[sensor_id][reg_idx])
+    {
+        uint16_t last = report_last_value[sensor_id][reg_idx];
+        uint16_t diff = (val > last) ? (val - last) : (last - val);
+        bool silence_expired = (max_silence != 0) && (current_tick - report_last_sent_tick[sensor_id][reg_idx] >= max_silence);
+
+        if(diff <= deadband && !silence_expired)
+        {
+            return false;
+        }
+    }
+
+    report_sent[sensor_id][reg_idx] = true;
+    report_last_value[sensor_id][reg_idx] = val;
+    report_last_sent_tick[sensor_id][reg_idx] = current_tick;
+    return true;
+}
+
+// 送出累積的二進位樣本，呼叫端必須持有 report_lock
+static void value_reporter_flush_frame(struct value_reporter_sample *samples, size_t *count)
+{
+    uint8_t frame[REPORT_FRAME_MAX_LEN];
+
+    if(*count == 0)
+    {
+        return;
+    }
+
+    int len = value_reporter_make_frame(frame, sizeof(frame), samples, *count);
+    if(len > 0 && report_output != NULL)
+    {
+        report_output(frame, len, true);
+    }
+    *count = 0;
+}
+
+// 送出一個感測器累積的文字回報行，呼叫端必須持有 report_lock
+static void value_reporter_flush_line(char *line, size_t *line_len)
+{
+    if(*line_len == 0)
+    {
+        return;
+    }
+
+    if(report_output != NULL)
+    {
+        report_output((const uint8_t *)line, *line_len, false);
+    }else
+    {
+        LOG_INF("Report: %s", line);
+    }
+    *line_len = 0;
+}
+
+// 送出累積的統計框架，呼叫端必須持有 report_lock
+static void value_reporter_flush_agg_frame(struct value_reporter_aggregate *aggs, size_t *count)
+{
+    uint8_t frame[REPORT_FRAME_MAX_LEN];
+
+    if(*count == 0)
     {
-        for(int reg_idx = 0; reg_idx < TOTAL_REG_NUM; reg_idx++)
+        return;
+    }
+
+    int len = value_reporter_make_agg_frame(frame, sizeof(frame), aggs, *count);
+    if(len > 0 && report_output != NULL)
+    {
+        report_output(frame, len, true);
+    }
+    *count = 0;
+}
+
+// 安排下一次內部取樣，advance 時以固定間隔累加避免漂移；呼叫端必須持有 report_lock
+static void value_reporter_schedule_sampling(bool advance)
+{
+    if(!value_reporter_started)
+    {
+        return;
+    }
+
+    if(agg_entry_num == 0)
+    {
+        k_work_cancel_delayable(&value_reporter_sample_work);
+        return;
+    }
+
+    int64_t now = k_uptime_get();
+    if(advance)
+    {
+        agg_next_sample_ms += VALUE_REPORTER_AGG_SAMPLE_MS;
+        if(agg_next_sample_ms < now)
         {
-            bool need_report = false;
-            need_report = value_reporter_check_reg_need_report(id, register_map[reg_idx], report_last_tick[id][reg_idx], current_tick);
+            agg_next_sample_ms = now;
+        }
+    }else if(k_work_delayable_is_pending(&value_reporter_sample_work))
+    {
+        return;
+    }else
+    {
+        agg_next_sample_ms = now + VALUE_REPORTER_AGG_SAMPLE_MS;
+    }
+    k_work_reschedule_for_queue(&value_reporter_work_q, &value_reporter_sample_work, K_MSEC(agg_next_sample_ms - now));
+}
 
-            if(need_report)
+static void value_reporter_sample_handler(struct k_work *work) {
+    uint16_t values[TOTAL_SENSOR_ID][TOTAL_REG_NUM];
+    bool fresh[TOTAL_SENSOR_ID];
+    uint32_t updated_ms;
+
+    for(uint8_t id = 0; id < TOTAL_SENSOR_ID; id++)
+    {
+        fresh[id] = (sensor_handler_get_snapshot(id, values[id], &updated_ms) == 0) && (updated_ms != agg_sampled_ms[id]);
+        if(fresh[id])
+        {
+            agg_sampled_ms[id] = updated_ms;
+        }
+    }
+
+    k_mutex_lock(&report_lock, K_FOREVER);
+    for(size_t i = 0; i < agg_entry_num; i++)
+    {
+        uint8_t id = agg_entries[i] / TOTAL_REG_NUM;
+        uint8_t reg_idx = agg_entries[i] % TOTAL_REG_NUM;
+        if(fresh[id])
+        {
+            accumulator_add(&report_acc[id][reg_idx], values[id][reg_idx]);
+        }
+    }
+    value_reporter_schedule_sampling(true);
+    k_mutex_unlock(&report_lock);
+}
+
+static void value_reporter_work_handler(struct k_work *work) {
+
+    // 同一次喚醒中到期的暫存器依感測器合併成一行，標頭與傳輸成本每個感測器只付一次
+    char lines[TOTAL_SENSOR_ID][MAX_REPORT_LINE_LEN];
+    size_t line_lens[TOTAL_SENSOR_ID] = {0};
+    char agg_lines[TOTAL_SENSOR_ID][MAX_REPORT_LINE_LEN];
+    size_t agg_line_lens[TOTAL_SENSOR_ID] = {0};
+    struct value_reporter_sample samples[REPORT_FRAME_MAX_SAMPLES];
+    size_t sample_count = 0;
+    struct value_reporter_aggregate aggs[REPORT_AGG_FRAME_MAX_RECORDS];
+    size_t agg_count = 0;
+
+    k_mutex_lock(&report_lock, K_FOREVER);
+    // 只處理已到期的項目，成本與啟用的訂閱數成正比，與暫存器表大小無關
+    while(report_heap_len > 0)
+    {
+        uint8_t id = report_heap[0].sensor_id;
+        uint8_t reg_idx = report_heap[0].reg_idx;
+        uint32_t period = report_periods[id][reg_idx];
+        uint8_t unit = report_units[id][reg_idx];
+        uint32_t current_tick = value_reporter_get_tick(unit);
+
+        if(!value_reporter_check_reg_need_report(id, register_map[reg_idx], report_last_tick[id][reg_idx], current_tick))
+        {
+            break;
+        }
+
+        // 依系統運行時間一次推進所有已經過的週期，工作執行緒延遲時不會因喚醒次數少而漏算，也維持原本的時間格點
+        report_last_tick[id][reg_idx] += ((current_tick - report_last_tick[id][reg_idx]) / period) * period;
+        uint32_t timestamp = report_last_tick[id][reg_idx] * value_reporter_unit_ms(unit);
+
+        if(report_aggregate[id][reg_idx])
+        {
+            struct report_accumulator *acc = &report_acc[id][reg_idx];
+            struct value_reporter_aggregate *agg = &aggs[agg_count];
+
+            // 週期內還沒有內部取樣時 (週期短於取樣間隔) 以目前的值作為唯一樣本
+            if(acc->count == 0)
+            {
+                accumulator_add(acc, sensor_handler_get_reg_value(id, reg_idx));
+            }
+            agg->sensor_id = id;
+            agg->reg = register_map[reg_idx];
+            agg->timestamp = timestamp;
+            accumulator_take(acc, agg);
+            history_push(id, reg_idx, agg->timestamp, agg->mean);
+
+            if(report_format == VALUE_REPORTER_FORMAT_BINARY && report_output != NULL)
+            {
+                if(++agg_count == REPORT_AGG_FRAME_MAX_RECORDS)
+                {
+                    value_reporter_flush_agg_frame(aggs, &agg_count);
+                }
+            }else
             {
-                uint16_t reg_val = sensor_handler_get_reg_value(id, reg_idx);
-                uint32_t period = report_periods[id][reg_idx];
-                value_reporter_make_report(report_buff, MAX_REPORT_LEN, id, register_map[reg_idx], reg_val, period);
-                report_last_tick[id][reg_idx] = current_tick;
-                LOG_INF("Report: %s", report_buff);
+                if(value_reporter_append_agg_report(agg_lines[id], MAX_REPORT_LINE_LEN, &agg_line_lens[id], agg) != 0)
+                {
+                    // 這一行已滿，先送出再開始新的一行
+                    value_reporter_flush_line(agg_lines[id], &agg_line_lens[id]);
+                    value_reporter_append_agg_report(agg_lines[id], MAX_REPORT_LINE_LEN, &agg_line_lens[id], agg);
+                }
+            }
+        }else
+        {
+            uint16_t reg_val = sensor_handler_get_reg_value(id, reg_idx);
+            history_push(id, reg_idx, timestamp, reg_val);
+            if(!value_reporter_check_value_need_report(id, reg_idx, reg_val, current_tick))
+            {
+                // 數值在 deadband 內，只推進排程不送出
+            }else if(report_format == VALUE_REPORTER_FORMAT_BINARY && report_output != NULL)
+            {
+                // 同一次喚醒中到期的樣本合併成一個框架
+                samples[sample_count].sensor_id = id;
+                samples[sample_count].reg = register_map[reg_idx];
+                samples[sample_count].value = reg_val;
+                samples[sample_count].timestamp = timestamp;
+                if(++sample_count == REPORT_FRAME_MAX_SAMPLES)
+                {
+                    value_reporter_flush_frame(samples, &sample_count);
+                }
+            }else
+            {
+                if(value_reporter_append_report(lines[id], MAX_REPORT_LINE_LEN, &line_lens[id], id, register_map[reg_idx], reg_val, period, unit) != 0)
+                {
+                    // 這一行已滿，先送出再開始新的一行
+                    value_reporter_flush_line(lines[id], &line_lens[id]);
+                    value_reporter_append_report(lines[id], MAX_REPORT_LINE_LEN, &line_lens[id], id, register_map[reg_idx], reg_val, period, unit);
+                }
             }
         }
+
+        report_heap[0].deadline = report_deadline_ms(id, reg_idx);
+        report_heap_fix(0);
+    }
+    value_reporter_flush_frame(samples, &sample_count);
+    value_reporter_flush_agg_frame(aggs, &agg_count);
+    for(int id = 0; id < TOTAL_SENSOR_ID; id++)
+    {
+        value_reporter_flush_line(lines[id], &line_lens[id]);
+        value_reporter_flush_line(agg_lines[id], &agg_line_lens[id]);
     }
-    current_tick++;
+    value_reporter_schedule_next();
+    k_mutex_unlock(&report_lock);
+}
+
+void value_reporter_set_output(value_reporter_output_t output)
+{
+    k_mutex_lock(&report_lock, K_FOREVER);
+    report_output = output;
+    k_mutex_unlock(&report_lock);
+}
+
+int value_reporter_set_deadband(uint8_t sensorId, uint8_t reg, uint16_t deadband, uint32_t max_silence)
+{
+    int reg_index = atm90e26_get_register_index(reg);
+
+    if(sensorId >= TOTAL_SENSOR_ID || reg_index == REG_NOT_VALIDE)
+    {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&report_lock, K_FOREVER);
+    report_deadband[sensorId][reg_index] = deadband;
+    report_max_silence[sensorId][reg_index] = max_silence;
+    // 設定改變後下一次取樣一定送出，作為新的比較基準
+    report_sent[sensorId][reg_index] = false;
+    k_mutex_unlock(&report_lock);
+    LOG_DBG("Set deadband: %u, %02X, %u, %u", sensorId, reg, deadband, max_silence);
+    return 0;
+}
+
+size_t value_reporter_history_read(uint8_t sensorId, uint8_t reg, const uint32_t *since, struct value_reporter_sample *samples, size_t max)
+{
+    int reg_index = atm90e26_get_register_index(reg);
+    size_t n = 0;
+
+    if(sensorId >= TOTAL_SENSOR_ID || reg_index == REG_NOT_VALIDE || samples == NULL)
+    {
+        return 0;
+    }
+
+    k_mutex_lock(&report_lock, K_FOREVER);
+    uint8_t slot = history_slot[sensorId][reg_index];
+    if(slot != 0)
+    {
+        const struct history_ring *ring = &history_pool[slot - 1];
+        uint32_t first = (ring->count > VALUE_REPORTER_HISTORY_DEPTH) ? (ring->count - VALUE_REPORTER_HISTORY_DEPTH) : 0;
+
+        // 由舊到新掃描，時間戳會回繞，以差值判斷是否在 since 之後
+        for(uint32_t i = first; i != ring->count && n < max; i++)
+        {
+            const struct history_sample *sample = &ring->samples[i % VALUE_REPORTER_HISTORY_DEPTH];
+            if(since == NULL || (int32_t)(sample->timestamp - *since) >= 0)
+            {
+                samples[n].sensor_id = sensorId;
+                samples[n].reg = reg;
+                samples[n].value = sample->value;
+                samples[n].timestamp = sample->timestamp;
+                n++;
+            }
+        }
+    }
+    k_mutex_unlock(&report_lock);
+    return n;
+}
+
+int value_reporter_get_register_addr(uint8_t reg_idx)
+{
+    if(reg_idx >= ARRAY_SIZE(register_map))
+    {
+        return REG_NOT_VALIDE;
+    }
+    return register_map[reg_idx];
+}
+
+uint32_t value_reporter_get_poll_mask(uint8_t sensorId)
+{
+    if(sensorId >= TOTAL_SENSOR_ID)
+    {
+        return 0;
+    }
+    return (uint32_t)atomic_get(&report_poll_mask[sensorId]);
+}
+
+int value_reporter_set_aggregate(uint8_t sensorId, uint8_t reg, bool enable)
+{
+    int reg_index = atm90e26_get_register_index(reg);
+
+    if(sensorId >= TOTAL_SENSOR_ID || reg_index == REG_NOT_VALIDE)
+    {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&report_lock, K_FOREVER);
+    report_aggregate[sensorId][reg_index] = enable;
+    agg_list_update(sensorId, reg_index);
+    k_mutex_unlock(&report_lock);
+    return 0;
+}
+
+int value_reporter_set_format(enum value_reporter_format format)
+{
+    if(format != VALUE_REPORTER_FORMAT_TEXT && format != VALUE_REPORTER_FORMAT_BINARY)
+    {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&report_lock, K_FOREVER);
+    report_format = format;
+    k_mutex_unlock(&report_lock);
+    return 0;
+}
+
+enum value_reporter_format value_reporter_get_format(void)
+{
+    return report_format;
 }
-K_TIMER_DEFINE(value_reporter_timer, value_reporter_timer_handler, NULL);
 
 bool value_reporter_start(void)
 {
-    k_timer_start(&value_reporter_timer, K_SECONDS(1), K_SECONDS(1));
+    k_work_queue_init(&value_reporter_work_q);
+    k_work_queue_start(&value_reporter_work_q, value_reporter_stack,
+                       K_THREAD_STACK_SIZEOF(value_reporter_stack),
+                       VALUE_REPORTER_PRIORITY, NULL);
+    k_thread_name_set(&value_reporter_work_q.thread, "value_reporter");
+
+    k_mutex_lock(&report_lock, K_FOREVER);
+    value_reporter_started = true;
+    value_reporter_schedule_next();
+    value_reporter_schedule_sampling(false);
+    k_mutex_unlock(&report_lock);
+    return true;
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef VALUE_REPORTER_H__
 #define VALUE_REPORTER_H__
 #include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/kernel.h>
 
@@ -9,8 +11,38 @@
 #define REG_NOT_VALIDE  (-1)
 #define PERIOD_DISABLE_REPORT (0x00000000)
 #define PERIOD_NOT_VALIDE (0xFFFFFFFF)
-#define MAX_REPORT_LEN  (26U)
+#define MAX_REPORT_LEN  (28U)
 #define MAX_PERIOD  (9999)
+// 合併多個暫存器的回報行最大長度 (含 '\0')
+#define MAX_REPORT_LINE_LEN  (96U)
+// 毫秒週期的下限 (100 Hz)
+#define MIN_PERIOD_MS  (10)
+
+// 二進位回報框架：<同步位元組> <樣本數> <樣本 x N> <CRC16 (LE)>
+// 每個樣本 8 bytes：<sensor_id> <reg> <value (LE)> <timestamp ms (LE)>
+#define REPORT_FRAME_SYNC  (0xA5)
+#define REPORT_FRAME_SAMPLE_LEN  (8U)
+#define REPORT_FRAME_MAX_SAMPLES  (8U)
+#define REPORT_FRAME_OVERHEAD  (4U)
+#define REPORT_FRAME_MAX_LEN  (REPORT_FRAME_OVERHEAD + REPORT_FRAME_MAX_SAMPLES * REPORT_FRAME_SAMPLE_LEN)
+
+// 統計回報的二進位框架：<同步位元組> <筆數> <統計 x N> <CRC16 (LE)>
+// 每筆 16 bytes：<sensor_id> <reg> <min> <max> <mean> <rms> <count> <timestamp ms> (LE)
+#define REPORT_AGG_FRAME_SYNC  (0xA6)
+#define REPORT_AGG_RECORD_LEN  (16U)
+#define REPORT_AGG_FRAME_MAX_RECORDS  (4U)
+// 統計模式的內部取樣間隔 (ms)
+#define VALUE_REPORTER_AGG_SAMPLE_MS  (CONFIG_VALUE_REPORTER_AGG_SAMPLE_MS)
+
+// 取樣歷史：可同時保存歷史的項目數與每個項目保存的樣本數
+#define VALUE_REPORTER_HISTORY_SLOTS  (16U)
+#define VALUE_REPORTER_HISTORY_DEPTH  (CONFIG_VALUE_REPORTER_HISTORY_DEPTH)
+
+// 回報週期的時間單位
+enum value_reporter_unit {
+    VALUE_REPORTER_UNIT_S = 0,
+    VALUE_REPORTER_UNIT_MS = 1
+};
 enum ATM90E26_ENG_REGSTERS {
     APENG = 0x40,
     ANENG = 0x41,
@@ -35,6 +67,104 @@ enum ATM90E26_ENG_REGSTERS {
     SMEAN2 = 0x6F
 };
 
+// 回報的輸出格式
+enum value_reporter_format {
+    VALUE_REPORTER_FORMAT_TEXT = 0,
+    VALUE_REPORTER_FORMAT_BINARY = 1
+};
+
+// 一筆暫存器取樣
+struct value_reporter_sample {
+    uint8_t sensor_id;
+    uint8_t reg;
+    uint16_t value;
+    uint32_t timestamp;  // 取樣的預定時間 (系統運行時間 ms)
+};
+
+// 一個回報週期內的統計
+struct value_reporter_aggregate {
+    uint8_t sensor_id;
+    uint8_t reg;
+    uint16_t min;
+    uint16_t max;
+    uint16_t mean;
+    uint16_t rms;
+    uint16_t count;      // 取樣數 (超過 65535 時為 65535)
+    uint32_t timestamp;  // 週期結束的預定時間 (系統運行時間 ms)
+};
+
+/**
+ * @brief 回報輸出函式，在回報工作佇列執行緒中呼叫，不可阻塞。
+ *
+ * @param data   文字格式時為以 '\0' 結尾的回報字串 (不含換行)，二進位格式時為一個完整框架。
+ * @param len    資料長度 (不含 '\0')。
+ * @param binary 資料是否為二進位框架。
+ */
+typedef void (*value_reporter_output_t)(const uint8_t *data, size_t len, bool binary);
+
 uint32_t value_reporter_set_report_period(uint8_t sensorId, uint8_t reg, uint32_t period);
+uint32_t value_reporter_set_report_period_unit(uint8_t sensorId, uint8_t reg, uint32_t period, enum value_reporter_unit unit);
 bool value_reporter_start(void);
+void value_reporter_set_output(value_reporter_output_t output);
+/**
+ * @brief 設定變化觸發回報。
+ *
+ * 設定後每個週期仍會取樣，但只有數值與上次送出的值相差超過 deadband，
+ * 或距離上次送出已達 max_silence (與週期相同單位，0 代表不限制) 時才送出。
+ * deadband 為 0 時恢復為每個週期都回報。
+ *
+ * @return 0 表示成功，-EINVAL 表示感測器或暫存器不合法。
+ */
+int value_reporter_set_deadband(uint8_t sensorId, uint8_t reg, uint16_t deadband, uint32_t max_silence);
+int value_reporter_set_format(enum value_reporter_format format);
+/**
+ * @brief 取得暫存器索引對應的 ATM90E26 暫存器位址。
+ *
+ * 索引順序與 sensor_handler_get_reg_value() 的 reg 參數相同。
+ *
+ * @return 暫存器位址，索引不合法時回傳 REG_NOT_VALIDE。
+ */
+int value_reporter_get_register_addr(uint8_t reg_idx);
+/**
+ * @brief 取得一個感測器啟用回報的暫存器。
+ *
+ * 可在任何執行緒呼叫，不加鎖。sensor_handler 只輪詢這些暫存器。
+ *
+ * @return 以暫存器索引為位元的遮罩，感測器不合法時回傳 0。
+ */
+uint32_t value_reporter_get_poll_mask(uint8_t sensorId);
+/**
+ * @brief 設定統計回報。
+ *
+ * 啟用後以 VALUE_REPORTER_AGG_SAMPLE_MS 的間隔取樣 (只計入 sensor_handler 更新過的快照)，每個回報週期送出該週期的
+ * 最小值、最大值、平均值、RMS 與取樣數 (+SYSAGG 或統計框架)，不套用 deadband。
+ *
+ * @return 0 表示成功，-EINVAL 表示感測器或暫存器不合法。
+ */
+int value_reporter_set_aggregate(uint8_t sensorId, uint8_t reg, bool enable);
+/**
+ * @brief 依時間順序讀取一個 (感測器, 暫存器) 的取樣歷史。
+ *
+ * 每個啟用回報的項目保存最近 VALUE_REPORTER_HISTORY_DEPTH 筆取樣 (不受 deadband 影響)。
+ * 分批讀取時以最後一筆的 timestamp + 1 作為下一次的 since (回繞到 0 也是有效的時間)。
+ *
+ * @param since   只讀取 timestamp 不早於 *since (ms) 的樣本，NULL 代表全部。
+ * @param samples 輸出樣本。
+ * @param max     最多讀取的樣本數。
+ * @return 讀到的樣本數。
+ */
+size_t value_reporter_history_read(uint8_t sensorId, uint8_t reg, const uint32_t *since, struct value_reporter_sample *samples, size_t max);
+/**
+ * @brief 將樣本編碼為二進位回報框架。
+ *
+ * @return 框架長度，參數不合法或緩衝區不足時回傳 -1。
+ */
+int value_reporter_make_frame(uint8_t *buff, size_t buff_size, const struct value_reporter_sample *samples, size_t count);
+/**
+ * @brief 將統計編碼為二進位統計框架。
+ *
+ * @return 框架長度，參數不合法或緩衝區不足時回傳 -1。
+ */
+int value_reporter_make_agg_frame(uint8_t *buff, size_t buff_size, const struct value_reporter_aggregate *aggs, size_t count);
+enum value_reporter_format value_reporter_get_format(void);
 #endif // VALUE_REPORTER_H__
\ No newline at end of file
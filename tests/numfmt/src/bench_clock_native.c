@@ -0,0 +1,12 @@
+// native_sim 執行器 (host) 端的計時函式，在 host 環境中編譯，可直接使用 host 的 libc
+#include <stdint.h>
+#include <time.h>
+
+// host 單調時鐘 (奈秒)，不受 native_sim 模擬時間影響
+uint64_t bench_clock_native_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
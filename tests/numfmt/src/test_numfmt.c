@@ -0,0 +1,349 @@
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include <zephyr/ztest_assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "numfmt.c"
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+// native_sim 的 k_cycle_get_32() 是模擬時間，量不到實際執行時間，改用 host 的單調時鐘 (bench_clock_native.c)
+#define BENCH_CLOCK_UNIT "ns"
+extern uint64_t bench_clock_native_ns(void);
+
+static void bench_clock_init(void)
+{
+}
+
+static uint32_t bench_clock_get(void)
+{
+    return (uint32_t)bench_clock_native_ns();
+}
+#elif defined(CONFIG_CPU_CORTEX_M_HAS_DWT)
+#include <cmsis_core.h>
+// 目標板上使用 DWT 週期計數器，以 CPU 時脈計數
+#define BENCH_CLOCK_UNIT "cycles"
+
+static void bench_clock_init(void)
+{
+#if defined(CONFIG_ARMV8_M_MAINLINE)
+    DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+#else
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#endif
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static uint32_t bench_clock_get(void)
+{
+    return DWT->CYCCNT;
+}
+#else
+// 沒有 DWT 時退回系統計時器，解析度依平台而定
+#define BENCH_CLOCK_UNIT "timer cycles"
+
+static void bench_clock_init(void)
+{
+}
+
+static uint32_t bench_clock_get(void)
+{
+    return k_cycle_get_32();
+}
+#endif
+
+// 基準測試的數值個數
+#define NUMFMT_BENCH_COUNT 4096
+// 十六進位緩衝區基準測試的位元組數
+#define NUMFMT_BENCH_HEX_SIZE 1024
+
+/* -------------------------------------------------------------------------- */
+/* 測試案例 (Test Cases)                                                  */
+/* -------------------------------------------------------------------------- */
+ZTEST_SUITE(numfmt_suite, NULL, NULL, NULL, NULL, NULL);
+
+/**
+ * @brief 測試：十進位輸出
+ * 期望：結果與 "%u"、"%d"、"%04u" 相同，包含邊界值
+ */
+ZTEST(numfmt_suite, test_dec_format)
+{
+    char buff[16];
+    size_t len;
+
+    len = numfmt_u32_to_dec(buff, 0);
+    zassert_equal(len, 1);
+    zassert_mem_equal(buff, "0", 1);
+
+    len = numfmt_u32_to_dec(buff, UINT32_MAX);
+    zassert_equal(len, 10);
+    zassert_mem_equal(buff, "4294967295", 10);
+
+    len = numfmt_i32_to_dec(buff, INT32_MIN);
+    zassert_equal(len, 11);
+    zassert_mem_equal(buff, "-2147483648", 11);
+
+    len = numfmt_i32_to_dec(buff, -5);
+    zassert_equal(len, 2);
+    zassert_mem_equal(buff, "-5", 2);
+
+    len = numfmt_u32_to_dec_pad(buff, 100, 4);
+    zassert_equal(len, 4);
+    zassert_mem_equal(buff, "0100", 4);
+
+    len = numfmt_u32_to_dec_pad(buff, 123456, 4);
+    zassert_equal(len, 6);
+    zassert_mem_equal(buff, "123456", 6);
+}
+
+/**
+ * @brief 測試：十六進位輸出
+ * 期望：結果與 "%0<digits>X" 相同，只輸出低 digits 個 nibble
+ */
+ZTEST(numfmt_suite, test_hex_format)
+{
+    char buff[8];
+
+    numfmt_u32_to_hex(buff, 0x4E, 2);
+    zassert_mem_equal(buff, "4E", 2);
+
+    numfmt_u32_to_hex(buff, 0x32ED, 4);
+    zassert_mem_equal(buff, "32ED", 4);
+
+    numfmt_u32_to_hex(buff, 0x1234ABCD, 4);
+    zassert_mem_equal(buff, "ABCD", 4);
+
+    numfmt_u32_to_hex(buff, 0x9AF0, 8);
+    zassert_mem_equal(buff, "00009AF0", 8);
+}
+
+/**
+ * @brief 測試：十進位與十六進位讀取
+ * 期望：
+ * 1. 回傳讀取的數字個數，遇到非數字字元或長度限制即停止
+ * 2. 開頭不是數字時回傳 0
+ * 3. 超出 uint64_t 範圍時得到 UINT64_MAX
+ */
+ZTEST(numfmt_suite, test_parse)
+{
+    uint64_t val = 0;
+
+    zassert_equal(numfmt_dec_to_u64("123456789012,5", 14, &val), 12);
+    zassert_equal(val, 123456789012ULL);
+    zassert_equal(numfmt_dec_to_u64("12345678", 4, &val), 4);
+    zassert_equal(val, 1234);
+    zassert_equal(numfmt_dec_to_u64(",1", 2, &val), 0);
+    zassert_equal(numfmt_dec_to_u64("18446744073709551616", 20, &val), 20);
+    zassert_equal(val, UINT64_MAX);
+
+    zassert_equal(numfmt_hex_to_u64("1fA0,", 5, &val), 4);
+    zassert_equal(val, 0x1FA0);
+    zassert_equal(numfmt_hex_to_u64("G", 1, &val), 0);
+    zassert_equal(numfmt_hex_to_u64("1FFFFFFFFFFFFFFFF", 17, &val), 17);
+    zassert_equal(val, UINT64_MAX);
+}
+
+/**
+ * @brief 測試：位元組緩衝區的十六進位編碼
+ * 期望：各種長度 (含不足 4 bytes 的尾段) 都與逐位元組 "%02X" 相同
+ */
+ZTEST(numfmt_suite, test_hex_buffer_encode)
+{
+    uint8_t data[37];
+    char buff[sizeof(data) * 2];
+    char ref[3];
+
+    for(size_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i * 0x3B + 0x0F);
+    }
+
+    for(size_t size = 0; size <= sizeof(data); size++)
+    {
+        memset(buff, 0, sizeof(buff));
+        numfmt_bytes_to_hex(buff, data, size);
+        for(size_t i = 0; i < size; i++)
+        {
+            snprintf(ref, sizeof(ref), "%02X", data[i]);
+            zassert_mem_equal(&buff[i * 2], ref, 2, "size %u, byte %u", (unsigned int)size, (unsigned int)i);
+        }
+        if(size < sizeof(data))
+        {
+            zassert_equal(buff[size * 2], 0, "size %u wrote past the end", (unsigned int)size);
+        }
+    }
+}
+
+/**
+ * @brief 測試：位元組緩衝區的十六進位解碼
+ * 期望：
+ * 1. 大小寫混合的字串正確解碼，非 8 的倍數的長度由尾段處理
+ * 2. 奇數個數字時回傳奇數，最後一個數字不寫入
+ * 3. 遇到非十六進位字元 (含 SWAR 區段內與高位元字元) 時停止並回傳已讀取的數字個數
+ * 4. data 為 NULL 時只檢查
+ */
+ZTEST(numfmt_suite, test_hex_buffer_decode)
+{
+    static const uint8_t expect[] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0xFE, 0xDC, 0xBA,
+    };
+    const char *text = "0123456789abCDefFEdcBA";
+    uint8_t data[16];
+
+    for(size_t len = 0; len <= strlen(text); len++)
+    {
+        memset(data, 0x55, sizeof(data));
+        zassert_equal(numfmt_hex_to_bytes(data, text, len), len);
+        zassert_mem_equal(data, expect, len / 2, "len %u", (unsigned int)len);
+        zassert_equal(data[len / 2], 0x55, "len %u wrote past the end", (unsigned int)len);
+    }
+
+    zassert_equal(numfmt_hex_to_bytes(data, "0123456:89ABCDEF", 16), 7);
+    zassert_equal(numfmt_hex_to_bytes(data, "01234567G9ABCDEF", 16), 8);
+    zassert_equal(numfmt_hex_to_bytes(data, "0123@567", 8), 4);
+    zassert_equal(numfmt_hex_to_bytes(data, "0123`567", 8), 4);
+    zassert_equal(numfmt_hex_to_bytes(data, "0123\xE1" "567", 8), 4);
+    zassert_equal(numfmt_hex_to_bytes(data, ",0123456", 8), 0);
+    zassert_equal(numfmt_hex_to_bytes(NULL, text, strlen(text)), strlen(text));
+}
+
+/**
+ * @brief 基準測試：與 snprintf/strtoul 比較每個數值的執行時間
+ * 期望：結果與 snprintf/strtoul 相同，並輸出兩者每個數值的時間 (native_sim 為 ns，目標板為 CPU cycles)
+ */
+ZTEST(numfmt_suite, test_benchmark)
+{
+    static uint32_t values[NUMFMT_BENCH_COUNT];
+    static char texts[NUMFMT_BENCH_COUNT][NUMFMT_U32_DEC_MAX_LEN + 1];
+    char buff[16];
+    char ref[16];
+    uint32_t start;
+    uint32_t fast_time;
+    uint32_t libc_time;
+    uint64_t sum = 0;
+    uint32_t seed = 0x12345678;
+
+    // 以 LCG 產生固定的數值序列，右移讓各種位數都有涵蓋
+    for(size_t i = 0; i < NUMFMT_BENCH_COUNT; i++)
+    {
+        seed = seed * 1664525U + 1013904223U;
+        values[i] = seed >> (i % 32);
+        snprintf(texts[i], sizeof(texts[i]), "%u", values[i]);
+    }
+    bench_clock_init();
+
+    start = bench_clock_get();
+    for(size_t i = 0; i < NUMFMT_BENCH_COUNT; i++)
+    {
+        sum += numfmt_u32_to_dec(buff, values[i]);
+    }
+    fast_time = bench_clock_get() - start;
+    start = bench_clock_get();
+    for(size_t i = 0; i < NUMFMT_BENCH_COUNT; i++)
+    {
+        sum += snprintf(ref, sizeof(ref), "%u", values[i]);
+    }
+    libc_time = bench_clock_get() - start;
+    TC_PRINT("u32 -> dec: numfmt %u, snprintf %u " BENCH_CLOCK_UNIT "/value\n",
+        fast_time / NUMFMT_BENCH_COUNT, libc_time / NUMFMT_BENCH_COUNT);
+
+    start = bench_clock_get();
+    for(size_t i = 0; i < NUMFMT_BENCH_COUNT; i++)
+    {
+        numfmt_u32_to_hex(buff, values[i], 8);
+        sum += buff[0];
+    }
+    fast_time = bench_clock_get() - start;
+    start = bench_clock_get();
+    for(size_t i = 0; i < NUMFMT_BENCH_COUNT; i++)
+    {
+        sum += snprintf(ref, sizeof(ref), "%08X", values[i]);
+    }
+    libc_time = bench_clock_get() - start;
+    TC_PRINT("u32 -> hex: numfmt %u, snprintf %u " BENCH_CLOCK_UNIT "/value\n",
+        fast_time / NUMFMT_BENCH_COUNT, libc_time / NUMFMT_BENCH_COUNT);
+
+    start = bench_clock_get();
+    for(size_t i = 0; i < NUMFMT_BENCH_COUNT; i++)
+    {
+        uint64_t val = 0;
+
+        numfmt_dec_to_u64(texts[i], strlen(texts[i]), &val);
+        sum += val;
+    }
+    fast_time = bench_clock_get() - start;
+    start = bench_clock_get();
+    for(size_t i = 0; i < NUMFMT_BENCH_COUNT; i++)
+    {
+        sum += strtoul(texts[i], NULL, 10);
+    }
+    libc_time = bench_clock_get() - start;
+    TC_PRINT("dec -> u64: numfmt %u, strtoul %u " BENCH_CLOCK_UNIT "/value\n",
+        fast_time / NUMFMT_BENCH_COUNT, libc_time / NUMFMT_BENCH_COUNT);
+
+    // 逐一與 libc 的結果比對
+    for(size_t i = 0; i < NUMFMT_BENCH_COUNT; i++)
+    {
+        uint64_t val = 0;
+        size_t len = numfmt_u32_to_dec(buff, values[i]);
+
+        zassert_equal(len, strlen(texts[i]));
+        zassert_mem_equal(buff, texts[i], len);
+        zassert_equal(numfmt_dec_to_u64(texts[i], len, &val), len);
+        zassert_equal(val, values[i]);
+
+        numfmt_u32_to_hex(buff, values[i], 8);
+        snprintf(ref, sizeof(ref), "%08X", values[i]);
+        zassert_mem_equal(buff, ref, 8);
+    }
+    zassert_not_equal(sum, 0);
+}
+
+/**
+ * @brief 基準測試：位元組緩衝區的十六進位編解碼與逐位元組轉換比較
+ * 期望：來回轉換後內容不變，並輸出兩者每 KiB 的時間 (native_sim 為 ns，目標板為 CPU cycles)
+ */
+ZTEST(numfmt_suite, test_hex_buffer_benchmark)
+{
+    static uint8_t data[NUMFMT_BENCH_HEX_SIZE];
+    static uint8_t decoded[NUMFMT_BENCH_HEX_SIZE];
+    static char text[NUMFMT_BENCH_HEX_SIZE * 2];
+    uint32_t start;
+    uint32_t fast_time;
+    uint32_t byte_time;
+    uint32_t seed = 0x9E3779B9;
+
+    for(size_t i = 0; i < NUMFMT_BENCH_HEX_SIZE; i++)
+    {
+        seed = seed * 1664525U + 1013904223U;
+        data[i] = (uint8_t)(seed >> 24);
+    }
+    bench_clock_init();
+
+    start = bench_clock_get();
+    numfmt_bytes_to_hex(text, data, NUMFMT_BENCH_HEX_SIZE);
+    zassert_equal(numfmt_hex_to_bytes(decoded, text, sizeof(text)), sizeof(text));
+    fast_time = bench_clock_get() - start;
+    zassert_mem_equal(decoded, data, NUMFMT_BENCH_HEX_SIZE);
+
+    // 舊的作法：每個位元組各自轉換，每個字元各自檢查
+    memset(decoded, 0, sizeof(decoded));
+    start = bench_clock_get();
+    for(size_t i = 0; i < NUMFMT_BENCH_HEX_SIZE; i++)
+    {
+        numfmt_u32_to_hex(&text[i * 2], data[i], 2);
+    }
+    for(size_t i = 0; i < NUMFMT_BENCH_HEX_SIZE; i++)
+    {
+        uint64_t val = 0;
+
+        zassert_equal(numfmt_hex_to_u64(&text[i * 2], 2, &val), 2);
+        decoded[i] = (uint8_t)val;
+    }
+    byte_time = bench_clock_get() - start;
+    zassert_mem_equal(decoded, data, NUMFMT_BENCH_HEX_SIZE);
+
+    TC_PRINT("hex buffer: numfmt %u, per byte %u " BENCH_CLOCK_UNIT "/KiB\n",
+        fast_time * 1024U / NUMFMT_BENCH_HEX_SIZE, byte_time * 1024U / NUMFMT_BENCH_HEX_SIZE);
+}
@@ -74,31 +74,304 @@ ZTEST(value_reporter_suite, test_sensor_id_not_in_range)
     zassert_equal(period, PERIOD_NOT_VALIDE, "Return value should be the same as input");
 }
 
+/**
+ * @brief 測試：設定毫秒單位的回報週期
+ * 期望：
+ * 1. 合法的毫秒週期回傳設定值
+ * 2. 低於 MIN_PERIOD_MS、超過 MAX_PERIOD 或未知的單位回傳 PERIOD_NOT_VALIDE
+ */
+ZTEST(value_reporter_suite, test_set_period_ms)
+{
+    uint32_t period = value_reporter_set_report_period_unit(1, IRMS, 100, VALUE_REPORTER_UNIT_MS);
+    zassert_equal(period, 100);
+
+    period = value_reporter_set_report_period_unit(1, IRMS, MIN_PERIOD_MS - 1, VALUE_REPORTER_UNIT_MS);
+    zassert_equal(period, PERIOD_NOT_VALIDE);
+
+    period = value_reporter_set_report_period_unit(1, IRMS, 100, 2);
+    zassert_equal(period, PERIOD_NOT_VALIDE);
+
+    period = value_reporter_set_report_period_unit(1, IRMS, PERIOD_DISABLE_REPORT, VALUE_REPORTER_UNIT_MS);
+    zassert_equal(period, PERIOD_DISABLE_REPORT);
+
+    period = value_reporter_set_report_period_unit(1, IRMS, MAX_PERIOD, VALUE_REPORTER_UNIT_MS);
+    zassert_equal(period, MAX_PERIOD);
+
+    period = value_reporter_set_report_period_unit(1, IRMS, MAX_PERIOD + 1, VALUE_REPORTER_UNIT_MS);
+    zassert_equal(period, PERIOD_NOT_VALIDE);
+
+    period = value_reporter_set_report_period_unit(1, IRMS, MAX_PERIOD + 1, VALUE_REPORTER_UNIT_S);
+    zassert_equal(period, PERIOD_NOT_VALIDE);
+
+    period = value_reporter_set_report_period_unit(1, IRMS, PERIOD_DISABLE_REPORT, VALUE_REPORTER_UNIT_MS);
+    zassert_equal(period, PERIOD_DISABLE_REPORT);
+}
+
+/**
+ * @brief 測試：輪詢遮罩跟隨回報設定
+ * 期望：啟用回報的暫存器設定對應位元，停用或設定失敗時不留下位元
+ */
+ZTEST(value_reporter_suite, test_poll_mask)
+{
+    zassert_equal(value_reporter_get_poll_mask(1), 0);
+
+    value_reporter_set_report_period_unit(1, IRMS, 100, VALUE_REPORTER_UNIT_MS);
+    value_reporter_set_report_period(1, SMEAN2, 1);
+    zassert_equal(value_reporter_get_poll_mask(1), BIT(7) | BIT(20));
+    zassert_equal(value_reporter_get_poll_mask(0), 0);
+
+    value_reporter_set_report_period_unit(1, IRMS, MAX_PERIOD + 1, VALUE_REPORTER_UNIT_MS);
+    zassert_equal(value_reporter_get_poll_mask(1), BIT(7) | BIT(20));
+
+    value_reporter_set_report_period(1, IRMS, PERIOD_DISABLE_REPORT);
+    value_reporter_set_report_period(1, SMEAN2, PERIOD_DISABLE_REPORT);
+    zassert_equal(value_reporter_get_poll_mask(1), 0);
+    zassert_equal(value_reporter_get_poll_mask(TOTAL_SENSOR_ID), 0);
+}
+
 
 ZTEST_SUITE(make_report_suite, NULL, NULL, NULL, NULL, NULL);
 
 ZTEST(make_report_suite, test_message_format)
 {
-    char target[] = "+SYSREG:0,2,4E,32ED,9999\n";
-    char msg_buff[MAX_REPORT_LEN] = {0};
-    int ret = value_reporter_make_report(msg_buff, sizeof(msg_buff), 2, 0x4E, 0x32ED, 9999);
-    printk("result: %s\r\n",msg_buff);
+    char target[] = "+SYSREG:0,2,4E,32ED,9999";
+    char line[MAX_REPORT_LINE_LEN] = {0};
+    size_t len = 0;
+    int ret = value_reporter_append_report(line, sizeof(line), &len, 2, 0x4E, 0x32ED, 9999, VALUE_REPORTER_UNIT_S);
+    printk("result: %s\r\n", line);
     zassert_equal(ret, 0);
-    zassert_str_equal(target, msg_buff);
+    zassert_str_equal(target, line);
+    zassert_equal(len, strlen(target));
+}
 
+ZTEST(make_report_suite, test_message_format_ms)
+{
+    char target[] = "+SYSREG:0,2,4E,32ED,0100,1";
+    char line[MAX_REPORT_LINE_LEN] = {0};
+    size_t len = 0;
+    int ret = value_reporter_append_report(line, sizeof(line), &len, 2, 0x4E, 0x32ED, 100, VALUE_REPORTER_UNIT_MS);
+    zassert_equal(ret, 0);
+    zassert_str_equal(target, line);
+    zassert_equal(len, strlen(target));
 }
 
 ZTEST(make_report_suite, test_period_out_of_bound)
 {
-    char msg_buff[MAX_REPORT_LEN] = {0};
-    int ret = value_reporter_make_report(msg_buff, sizeof(msg_buff), 2, 0x4E, 0x32ED, 10000);
+    char line[MAX_REPORT_LINE_LEN] = {0};
+    size_t len = 0;
+    int ret = value_reporter_append_report(line, sizeof(line), &len, 2, 0x4E, 0x32ED, 10000, VALUE_REPORTER_UNIT_S);
     zassert_equal(ret, -1);
-    ret = value_reporter_make_report(msg_buff, sizeof(msg_buff), 2, 0x4E, 0x32ED, -1);
+    zassert_equal(len, 0);
+    ret = value_reporter_append_report(line, sizeof(line), &len, 2, 0x4E, 0x32ED, -1, VALUE_REPORTER_UNIT_S);
     zassert_equal(ret, -1);
-    ret = value_reporter_make_report(msg_buff, sizeof(msg_buff), 2, 0x4E, 0x32ED, 5000);
+    zassert_equal(len, 0);
+    ret = value_reporter_append_report(line, sizeof(line), &len, 2, 0x4E, 0x32ED, 5000, VALUE_REPORTER_UNIT_S);
     zassert_equal(ret, 0);
 }
 
+/**
+ * @brief 測試：同一感測器的多個暫存器合併成一行
+ * 期望：第一組帶標頭，之後以 ';' 分隔；放不下時回傳 -1 且不改動已有內容
+ */
+ZTEST(make_report_suite, test_append_report)
+{
+    char line[MAX_REPORT_LINE_LEN] = {0};
+    size_t len = 0;
+
+    zassert_equal(value_reporter_append_report(line, sizeof(line), &len, 2, 0x4E, 0x32ED, 9999, VALUE_REPORTER_UNIT_S), 0);
+    zassert_str_equal(line, "+SYSREG:0,2,4E,32ED,9999");
+    zassert_equal(value_reporter_append_report(line, sizeof(line), &len, 2, 0x48, 0x0007, 100, VALUE_REPORTER_UNIT_MS), 0);
+    zassert_str_equal(line, "+SYSREG:0,2,4E,32ED,9999;48,0007,0100,1");
+    zassert_equal(len, strlen(line));
+
+    zassert_equal(value_reporter_append_report(line, len + 10, &len, 2, 0x49, 0x0001, 1, VALUE_REPORTER_UNIT_S), -1);
+    zassert_str_equal(line, "+SYSREG:0,2,4E,32ED,9999;48,0007,0100,1");
+    zassert_equal(value_reporter_append_report(line, sizeof(line), &len, 2, 0x49, 0x0001, MAX_PERIOD + 1, VALUE_REPORTER_UNIT_S), -1);
+}
+
+ZTEST_SUITE(make_frame_suite, NULL, NULL, NULL, NULL, NULL);
+
+/**
+ * @brief 測試：二進位回報框架的格式
+ * 期望：同步位元組、樣本數、每個樣本 8 bytes (LE) 與涵蓋樣本數及樣本的 CRC16
+ */
+ZTEST(make_frame_suite, test_frame_layout)
+{
+    const struct value_reporter_sample samples[] = {
+        { .sensor_id = 2, .reg = 0x4E, .value = 0x32ED, .timestamp = 0x12345678 },
+        { .sensor_id = 0, .reg = 0x48, .value = 0x0001, .timestamp = 0x0000000A },
+    };
+    const uint8_t target[] = {
+        REPORT_FRAME_SYNC, 2,
+        0x02, 0x4E, 0xED, 0x32, 0x78, 0x56, 0x34, 0x12,
+        0x00, 0x48, 0x01, 0x00, 0x0A, 0x00, 0x00, 0x00,
+    };
+    uint8_t frame[REPORT_FRAME_MAX_LEN] = {0};
+
+    int len = value_reporter_make_frame(frame, sizeof(frame), samples, 2);
+    zassert_equal(len, sizeof(target) + 2);
+    zassert_mem_equal(frame, target, sizeof(target));
+    zassert_equal(sys_get_le16(&frame[sizeof(target)]), crc16_ccitt(0xFFFF, &target[1], sizeof(target) - 1));
+}
+
+ZTEST(make_frame_suite, test_frame_bounds)
+{
+    struct value_reporter_sample samples[REPORT_FRAME_MAX_SAMPLES + 1] = {0};
+    uint8_t frame[REPORT_FRAME_MAX_LEN + REPORT_FRAME_SAMPLE_LEN] = {0};
+
+    zassert_equal(value_reporter_make_frame(frame, sizeof(frame), samples, 0), -1);
+    zassert_equal(value_reporter_make_frame(frame, sizeof(frame), samples, REPORT_FRAME_MAX_SAMPLES + 1), -1);
+    zassert_equal(value_reporter_make_frame(frame, REPORT_FRAME_OVERHEAD + REPORT_FRAME_SAMPLE_LEN - 1, samples, 1), -1);
+    zassert_equal(value_reporter_make_frame(frame, sizeof(frame), samples, REPORT_FRAME_MAX_SAMPLES), REPORT_FRAME_MAX_LEN);
+}
+
+ZTEST_SUITE(deadband_suite, NULL, NULL, NULL, NULL, NULL);
+
+/**
+ * @brief 測試：變化觸發回報
+ * 期望：
+ * 1. 第一次取樣一定送出
+ * 2. 變化不超過 deadband 時不送出，超過時送出並成為新的比較基準
+ * 3. 超過 max_silence 沒有送出時強制送出
+ */
+ZTEST(deadband_suite, test_deadband_and_silence)
+{
+    int reg_idx = atm90e26_get_register_index(PMEAN);
+
+    zassert_equal(value_reporter_set_deadband(1, PMEAN, 10, 5), 0);
+    zassert_true(value_reporter_check_value_need_report(1, reg_idx, 100, 0));
+    zassert_false(value_reporter_check_value_need_report(1, reg_idx, 110, 1));
+    zassert_false(value_reporter_check_value_need_report(1, reg_idx, 90, 2));
+    zassert_true(value_reporter_check_value_need_report(1, reg_idx, 111, 3));
+    zassert_false(value_reporter_check_value_need_report(1, reg_idx, 111, 7));
+    zassert_true(value_reporter_check_value_need_report(1, reg_idx, 111, 8));
+
+    zassert_equal(value_reporter_set_deadband(1, PMEAN, 0, 0), 0);
+    zassert_true(value_reporter_check_value_need_report(1, reg_idx, 111, 9));
+    zassert_true(value_reporter_check_value_need_report(1, reg_idx, 111, 10));
+}
+
+ZTEST(deadband_suite, test_deadband_invalid)
+{
+    zassert_equal(value_reporter_set_deadband(TOTAL_SENSOR_ID, PMEAN, 10, 0), -EINVAL);
+    zassert_equal(value_reporter_set_deadband(0, 0x47, 10, 0), -EINVAL);
+}
+
+ZTEST_SUITE(history_suite, NULL, NULL, NULL, NULL, NULL);
+
+/**
+ * @brief 測試：取樣歷史
+ * 期望：
+ * 1. 啟用回報後分配歷史緩衝區，依時間順序讀出，since 之前的樣本被略過
+ * 2. 超過 VALUE_REPORTER_HISTORY_DEPTH 時只保留最新的樣本
+ * 3. 停用回報後不再有歷史
+ */
+ZTEST(history_suite, test_history_read)
+{
+    struct value_reporter_sample samples[VALUE_REPORTER_HISTORY_DEPTH];
+    int reg_idx = atm90e26_get_register_index(URMS);
+    uint32_t since = 1101;
+
+    value_reporter_set_report_period(2, URMS, 1);
+    for(uint32_t i = 0; i < 4; i++)
+    {
+        history_push(2, reg_idx, 1000 + i * 100, 0x100 + i);
+    }
+    zassert_equal(value_reporter_history_read(2, URMS, NULL, samples, ARRAY_SIZE(samples)), 4);
+    zassert_equal(samples[0].timestamp, 1000);
+    zassert_equal(samples[3].value, 0x103);
+    zassert_equal(samples[3].reg, URMS);
+
+    zassert_equal(value_reporter_history_read(2, URMS, &since, samples, ARRAY_SIZE(samples)), 2);
+    zassert_equal(samples[0].timestamp, 1200);
+    zassert_equal(value_reporter_history_read(2, URMS, NULL, samples, 1), 1);
+    zassert_equal(samples[0].timestamp, 1000);
+
+    for(uint32_t i = 4; i < VALUE_REPORTER_HISTORY_DEPTH + 4; i++)
+    {
+        history_push(2, reg_idx, 1000 + i * 100, 0x100 + i);
+    }
+    zassert_equal(value_reporter_history_read(2, URMS, NULL, samples, ARRAY_SIZE(samples)), VALUE_REPORTER_HISTORY_DEPTH);
+    zassert_equal(samples[0].timestamp, 1400);
+
+    value_reporter_set_report_period(2, URMS, PERIOD_DISABLE_REPORT);
+    zassert_equal(value_reporter_history_read(2, URMS, NULL, samples, ARRAY_SIZE(samples)), 0);
+}
+
+/**
+ * @brief 測試：時間戳回繞時的分批讀取
+ * 期望：最後一筆為 0xFFFFFFFF 時下一批的 since 回繞為 0，只讀到回繞之後的樣本
+ */
+ZTEST(history_suite, test_history_read_wrap)
+{
+    struct value_reporter_sample samples[4];
+    int reg_idx = atm90e26_get_register_index(IRMS);
+    uint32_t since;
+
+    value_reporter_set_report_period(1, IRMS, 1);
+    history_push(1, reg_idx, 0xFFFFFFFEU, 1);
+    history_push(1, reg_idx, 0xFFFFFFFFU, 2);
+    history_push(1, reg_idx, 0, 3);
+    history_push(1, reg_idx, 1, 4);
+
+    zassert_equal(value_reporter_history_read(1, IRMS, NULL, samples, 2), 2);
+    since = samples[1].timestamp + 1;
+    zassert_equal(value_reporter_history_read(1, IRMS, &since, samples, ARRAY_SIZE(samples)), 2);
+    zassert_equal(samples[0].value, 3);
+    zassert_equal(samples[1].value, 4);
+
+    value_reporter_set_report_period(1, IRMS, PERIOD_DISABLE_REPORT);
+}
+
+ZTEST_SUITE(aggregate_suite, NULL, NULL, NULL, NULL, NULL);
+
+/**
+ * @brief 測試：週期統計
+ * 期望：
+ * 1. 累計後得到正確的最小值、最大值、平均值、RMS 與取樣數，取出後歸零
+ * 2. 統計框架的長度、同步位元組與欄位位置正確
+ * 3. 文字格式為 +SYSAGG:<SensorID>,<reg>,<min>,<max>,<mean>,<rms>,<count>，同一感測器的統計以 ';' 接在同一行
+ */
+ZTEST(aggregate_suite, test_aggregate_accumulate)
+{
+    struct report_accumulator acc;
+    struct value_reporter_aggregate agg = { .sensor_id = 1, .reg = URMS, .timestamp = 3000 };
+    uint8_t frame[REPORT_FRAME_MAX_LEN];
+    char buff[MAX_REPORT_LINE_LEN];
+    size_t len = 0;
+
+    accumulator_reset(&acc);
+    accumulator_add(&acc, 3);
+    accumulator_add(&acc, 4);
+    accumulator_add(&acc, 5);
+    accumulator_take(&acc, &agg);
+    zassert_equal(agg.min, 3);
+    zassert_equal(agg.max, 5);
+    zassert_equal(agg.mean, 4);
+    zassert_equal(agg.rms, 4);
+    zassert_equal(agg.count, 3);
+    zassert_equal(acc.count, 0);
+    zassert_equal(isqrt32(0xFFFE0001), 0xFFFF);
+
+    zassert_equal(value_reporter_make_agg_frame(frame, sizeof(frame), &agg, 1), REPORT_FRAME_OVERHEAD + REPORT_AGG_RECORD_LEN);
+    zassert_equal(frame[0], REPORT_AGG_FRAME_SYNC);
+    zassert_equal(frame[1], 1);
+    zassert_equal(frame[3], URMS);
+    zassert_equal(sys_get_le16(&frame[12]), 3);
+    zassert_equal(sys_get_le32(&frame[14]), 3000);
+    zassert_equal(value_reporter_make_agg_frame(frame, sizeof(frame), &agg, REPORT_AGG_FRAME_MAX_RECORDS + 1), -1);
+
+    // 同一個感測器的統計合併成一行，放不下時不修改這一行
+    zassert_equal(value_reporter_append_agg_report(buff, sizeof(buff), &len, &agg), 0);
+    zassert_equal(len, 34);
+    zassert_str_equal(buff, "+SYSAGG:1,49,0003,0005,0004,0004,3");
+    agg.reg = IRMS;
+    zassert_equal(value_reporter_append_agg_report(buff, sizeof(buff), &len, &agg), 0);
+    zassert_str_equal(buff, "+SYSAGG:1,49,0003,0005,0004,0004,3;48,0003,0005,0004,0004,3");
+    zassert_equal(value_reporter_append_agg_report(buff, len + 10, &len, &agg), -1);
+    zassert_equal(len, strlen(buff));
+}
+
 ZTEST_SUITE(check_reg_need_report_suite, NULL, NULL, NULL, NULL, NULL);
 
 ZTEST(check_reg_need_report_suite, test_return_value)
@@ -157,4 +430,149 @@ ZTEST(check_reg_need_report_suite, test_sensor_id_boundry_value)
     value_reporter_set_report_period(sensor_id, reg_addr, period);
     result = value_reporter_check_reg_need_report(sensor_id, reg_addr, last_tick, period);
     zassert_equal(result, false);
-}
\ No newline at end of file
+}
+// 停用所有項目，讓每個排程測試都從空的堆積開始
+static void report_schedule_test_reset(void *fixture)
+{
+    for(uint8_t id = 0; id < TOTAL_SENSOR_ID; id++)
+    {
+        for(uint8_t reg_idx = 0; reg_idx < TOTAL_REG_NUM; reg_idx++)
+        {
+            value_reporter_set_report_period(id, register_map[reg_idx], PERIOD_DISABLE_REPORT);
+        }
+    }
+}
+
+// 檢查堆積性質與位置索引
+static void report_heap_check(void)
+{
+    for(size_t i = 0; i < report_heap_len; i++)
+    {
+        zassert_equal(report_heap_pos[report_heap[i].sensor_id][report_heap[i].reg_idx], i + 1);
+        if(i > 0)
+        {
+            zassert_false(report_deadline_before(report_heap[i].deadline, report_heap[(i - 1) / 2].deadline));
+        }
+    }
+}
+
+// 依序取出堆積頂端，檢查到期時間的順序
+static void report_heap_check_pop(const uint32_t *expected, size_t count)
+{
+    zassert_equal(report_heap_len, count);
+    for(size_t i = 0; i < count; i++)
+    {
+        zassert_equal(report_heap[0].deadline, expected[i]);
+        report_heap_remove(0);
+        report_heap_check();
+    }
+    zassert_equal(report_heap_len, 0);
+}
+
+ZTEST_SUITE(report_schedule_suite, NULL, NULL, report_schedule_test_reset, report_schedule_test_reset, NULL);
+
+/**
+ * @brief 測試：最小堆積的插入、移除與重新排序
+ * 期望：
+ * 1. 頂端永遠是最早到期的項目，位置索引與堆積一致
+ * 2. 修改到期時間後 report_heap_fix() 把項目移到正確位置
+ * 3. 從中間移除的項目不再排程，其餘項目依到期時間取出
+ */
+ZTEST(report_schedule_suite, test_heap_order)
+{
+    const uint32_t deadlines[] = { 50, 10, 40, 20, 30, 60 };
+    const uint32_t expected[] = { 5, 10, 20, 30, 50 };
+
+    for(uint8_t i = 0; i < ARRAY_SIZE(deadlines); i++)
+    {
+        report_heap_insert(1, i, deadlines[i]);
+        report_heap_check();
+    }
+    zassert_equal(report_heap[0].deadline, 10);
+    zassert_equal(report_heap_pos[1][1], 1);
+
+    report_heap[report_heap_pos[1][5] - 1].deadline = 5;
+    report_heap_fix(report_heap_pos[1][5] - 1);
+    report_heap_check();
+    zassert_equal(report_heap_pos[1][5], 1);
+
+    report_heap[0].deadline = 45;
+    report_heap_fix(0);
+    report_heap_check();
+    zassert_equal(report_heap[0].deadline, 10);
+    report_heap[report_heap_pos[1][5] - 1].deadline = 5;
+    report_heap_fix(report_heap_pos[1][5] - 1);
+
+    report_heap_remove(report_heap_pos[1][2] - 1);
+    zassert_equal(report_heap_pos[1][2], 0);
+    report_heap_check();
+
+    report_heap_check_pop(expected, ARRAY_SIZE(expected));
+}
+
+/**
+ * @brief 測試：到期時間跨過 32 位元毫秒回繞
+ * 期望：回繞前的到期時間排在回繞後之前，相同時間不算較早
+ */
+ZTEST(report_schedule_suite, test_deadline_wrap)
+{
+    const uint32_t deadlines[] = { 0x00000010, 0xFFFFFFF0, 0x00000100, 0xFFFFFF00 };
+    const uint32_t expected[] = { 0xFFFFFF00, 0xFFFFFFF0, 0x00000010, 0x00000100 };
+
+    zassert_true(report_deadline_before(0xFFFFFFF0, 0x00000010));
+    zassert_false(report_deadline_before(0x00000010, 0xFFFFFFF0));
+    zassert_false(report_deadline_before(0x00000010, 0x00000010));
+    zassert_true(report_deadline_before(0x7FFFFFFF, 0x80000000));
+
+    for(uint8_t i = 0; i < ARRAY_SIZE(deadlines); i++)
+    {
+        report_heap_insert(0, i, deadlines[i]);
+        report_heap_check();
+    }
+    report_heap_check_pop(expected, ARRAY_SIZE(expected));
+}
+
+/**
+ * @brief 測試：改變週期或單位時重新排序
+ * 期望：
+ * 1. 同單位改變週期時保留上次回報時間，到期時間依新週期前後移動
+ * 2. 改變單位時從現在重新起算，下一個 tick 就到期
+ * 3. 停用的項目從堆積移除
+ */
+ZTEST(report_schedule_suite, test_schedule_update)
+{
+    int irms = atm90e26_get_register_index(IRMS);
+    int urms = atm90e26_get_register_index(URMS);
+    uint32_t irms_deadline;
+    uint32_t urms_deadline;
+
+    value_reporter_set_report_period(0, IRMS, 5);
+    value_reporter_set_report_period(0, URMS, 5);
+    zassert_equal(report_heap_len, 2);
+    report_heap_check();
+    irms_deadline = report_heap[report_heap_pos[0][irms] - 1].deadline;
+    zassert_equal(irms_deadline, report_deadline_ms(0, irms));
+
+    value_reporter_set_report_period(0, IRMS, 2);
+    report_heap_check();
+    zassert_equal(report_heap_pos[0][irms], 1);
+    zassert_equal(report_heap[0].deadline, irms_deadline - 3 * MSEC_PER_SEC);
+
+    value_reporter_set_report_period(0, IRMS, 9);
+    report_heap_check();
+    zassert_equal(report_heap_pos[0][urms], 1);
+    zassert_equal(report_heap[report_heap_pos[0][irms] - 1].deadline, irms_deadline + 4 * MSEC_PER_SEC);
+
+    value_reporter_set_report_period_unit(0, URMS, 100, VALUE_REPORTER_UNIT_MS);
+    report_heap_check();
+    zassert_equal(report_heap_pos[0][urms], 1);
+    urms_deadline = report_heap[0].deadline;
+    zassert_equal(urms_deadline, report_deadline_ms(0, urms));
+    zassert_true(report_deadline_before(urms_deadline, (uint32_t)k_uptime_get() + 2));
+
+    value_reporter_set_report_period(0, URMS, PERIOD_DISABLE_REPORT);
+    report_heap_check();
+    zassert_equal(report_heap_pos[0][urms], 0);
+    zassert_equal(report_heap_len, 1);
+    zassert_equal(report_heap_pos[0][irms], 1);
+}